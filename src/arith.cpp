@@ -14,20 +14,18 @@
  */
 #include <iostream>
 #include <cstdlib>
-#include <csignal>
-#include <unistd.h> // For sleep function
+#include "timeit.hpp"
+#include "result.hpp"
+#include "kernels.hpp"
 
-// Global variable to store iterations
-volatile unsigned long iter = 0;
-
-// This function is called when the alarm expires
-void report(int signum) {
-    std::cerr << "COUNT|" << iter << "|1|lps" << std::endl;
-    exit(0);
-}
+// Kernel entry point; the unixbench binary builds one per datum type (arith_run_int, ...)
+#ifndef ARITH_RUN
+#define ARITH_RUN arith_run
+unsigned long ARITH_RUN(const std::atomic<bool>& stop);
+#endif
 
 // Function to do some dumb stuff
-int dumb_stuff(int i) {
+static int dumb_stuff(int i) {
     #ifndef arithoh
     int x = 0, y = 0, z = 0;
     for (int i = 2; i <= 101; ++i) {
@@ -41,24 +39,37 @@ int dumb_stuff(int i) {
     #endif
 }
 
+unsigned long ARITH_RUN(const std::atomic<bool>& stop) {
+    // Iteration counter, kept volatile as in the original
+    volatile unsigned long iter = 0;
+
+    int result = 0;
+    // This loop runs until the stop flag is set
+    while (!stop.load(std::memory_order_relaxed)) {
+        ++iter;
+        result = dumb_stuff(result);
+    }
+    return iter;
+}
+
+#ifndef UB_KERNEL
 int main(int argc, char* argv[]) {
     if (argc != 2) {
         std::cerr << "Usage: " << argv[0] << " duration" << std::endl;
         return 1;
     }
 
-    int duration = std::atoi(argv[1]);
-
-    // Set up alarm call
-    std::signal(SIGALRM, report);
-    alarm(duration);
-
-    int result = 0;
-    // This loop will be interrupted by the alarm call
-    while (true) {
-        ++iter;
-        result = dumb_stuff(result);
+    double duration = parse_duration(argv[1]);
+    if (duration <= 0) {
+        std::cerr << "Invalid duration: " << argv[1] << std::endl;
+        return 1;
     }
 
+    BenchTimer timer;
+    timer.start(duration);
+    unsigned long iter = ARITH_RUN(bench_stop);
+
+    emit_result(BenchResult(bench_name(argv[0]), iter, timer.stop()));
     return 0;
 }
+#endif
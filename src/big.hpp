@@ -8,6 +8,8 @@
 
 #pragma once
 
+#include <cstdint>
+#include <iostream>
 #include <string>
 #include <vector>
 
@@ -35,6 +37,9 @@ struct Child {
     int firstJob = 0;
     int currentJob = 0;
     const char* line = nullptr;
+    uint64_t started = 0;   // now_ns() when the current job was forked
+    int lineEnd = 0;        // end of the complete lines typed; inputPos..lineEnd is still to be written
+    int pidfd = -1;         // exit notification for the current job
 };
 
 // Global variables
@@ -52,7 +57,8 @@ void wrapUp(const std::string& reason);
 void onAlarm(int);
 void pipeError(int);
 void grunt();
-void getWork();
+// Job script from `in`; relative "< input" files are looked up in `dir`
+void getWork(std::istream& in = std::cin, const std::string& dir = "");
 void fatal(const std::string& message);
 
 #endif //BIG_HPP
\ No newline at end of file
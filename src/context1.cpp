@@ -9,8 +9,21 @@
  * This file is a C++ rewrite of context1.c from the original UnixBench project.
  * Original project address: https://github.com/kdlucas/byte-unixbench/tree/v5.1.3
  *
+ * Modes (second argument):
+ *   process   two forked processes ping-pong over pipes (the original test)
+ *   pipe      two threads of one process over pipes
+ *   eventfd   two threads over a pair of eventfds
+ *   futex     two threads over FUTEX_WAIT/FUTEX_WAKE on a sequence word
+ *   condvar   two threads over std::mutex + std::condition_variable
  *
+ * Placement (third argument):
+ *   any       no pinning, the scheduler decides (the original behaviour)
+ *   same      both sides on one CPU: every round trip is two context switches
+ *   cross     two different physical cores: cross-core wakeup, no switch needed
+ *   smt       two SMT siblings of one core
  *
+ * process vs pipe on the same CPU separates the address-space switch from the
+ * scheduler wakeup; same vs cross separates the switch from the IPI.
  */
 
 #include <iostream>
@@ -18,9 +31,22 @@
 #include <cstring>
 #include <unistd.h>
 #include <vector>
+#include <atomic>
+#include <condition_variable>
 #include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
 
-#include <signal.h>
+#include <linux/futex.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include "timeit.hpp"
+#include "result.hpp"
+#include "histogram.hpp"
+#include "perfcount.hpp"
+#include "topology.hpp"
 // Declare global variable for iteration count
 unsigned long iter;
 
@@ -38,90 +64,375 @@ public:
     }
 };
 
-// Report function for alarm handler
-void report(int)
+// One direction of the ping-pong. recv() returns false once the sender has closed the link.
+class Link
 {
-    std::cerr << "COUNT|" << iter << "|1|lps" << std::endl;
-    std::exit(0);
+public:
+    virtual ~Link() = default;
+    virtual void send(unsigned long v) = 0;
+    virtual bool recv(unsigned long &v) = 0;
+    virtual void close_link() = 0;
+};
+
+class PipeLink : public Link
+{
+public:
+    PipeLink()
+    {
+        if (pipe(fd))
+            throw PipeException("Pipe creation failed");
+    }
+    ~PipeLink() override
+    {
+        close_read();
+        close_write();
+    }
+    void send(unsigned long v) override
+    {
+        if (write(fd[1], &v, sizeof(v)) != sizeof(v))
+            throw PipeException("Pipe write failed");
+    }
+    bool recv(unsigned long &v) override
+    {
+        ssize_t r = read(fd[0], &v, sizeof(v));
+        if (r == 0)
+            return false;
+        if (r != sizeof(v))
+        {
+            perror("read");
+            throw PipeException("Pipe read failed");
+        }
+        return true;
+    }
+    void close_link() override { close_write(); } // Reader sees EOF
+    // Each process of the process mode keeps only its own end
+    void close_read()
+    {
+        if (fd[0] >= 0)
+            close(fd[0]);
+        fd[0] = -1;
+    }
+    void close_write()
+    {
+        if (fd[1] >= 0)
+            close(fd[1]);
+        fd[1] = -1;
+    }
+
+private:
+    int fd[2] = {-1, -1};
+};
+
+class EventfdLink : public Link
+{
+public:
+    EventfdLink() : fd(eventfd(0, EFD_CLOEXEC))
+    {
+        if (fd < 0)
+            throw PipeException("eventfd creation failed");
+    }
+    ~EventfdLink() override { close(fd); }
+    // The eventfd counter carries v + 1 because a zero write does not wake the reader
+    void send(unsigned long v) override
+    {
+        uint64_t n = v + 1;
+        if (write(fd, &n, sizeof(n)) != sizeof(n))
+            throw PipeException("eventfd write failed");
+    }
+    bool recv(unsigned long &v) override
+    {
+        uint64_t n;
+        if (read(fd, &n, sizeof(n)) != sizeof(n))
+            throw PipeException("eventfd read failed");
+        if (closed.load(std::memory_order_acquire))
+            return false;
+        v = n - 1;
+        return true;
+    }
+    void close_link() override
+    {
+        closed.store(true, std::memory_order_release);
+        send(0);
+    }
+
+private:
+    int fd;
+    std::atomic<bool> closed{false};
+};
+
+class FutexLink : public Link
+{
+public:
+    void send(unsigned long v) override
+    {
+        value = v;
+        seq.fetch_add(1, std::memory_order_release);
+        syscall(SYS_futex, reinterpret_cast<uint32_t *>(&seq), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+    }
+    bool recv(unsigned long &v) override
+    {
+        uint32_t s;
+        while ((s = seq.load(std::memory_order_acquire)) == seen)
+            syscall(SYS_futex, reinterpret_cast<uint32_t *>(&seq), FUTEX_WAIT_PRIVATE, seen, nullptr, nullptr, 0);
+        seen = s;
+        if (closed.load(std::memory_order_acquire))
+            return false;
+        v = value;
+        return true;
+    }
+    void close_link() override
+    {
+        closed.store(true, std::memory_order_release);
+        send(0);
+    }
+
+private:
+    alignas(64) std::atomic<uint32_t> seq{0};
+    unsigned long value = 0;
+    std::atomic<bool> closed{false};
+    alignas(64) uint32_t seen = 0; // receiver side only
+};
+
+class CondvarLink : public Link
+{
+public:
+    void send(unsigned long v) override
+    {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            value = v;
+            full = true;
+        }
+        cv.notify_one();
+    }
+    bool recv(unsigned long &v) override
+    {
+        std::unique_lock<std::mutex> lock(m);
+        cv.wait(lock, [this] { return full || closed; });
+        if (closed)
+            return false;
+        full = false;
+        v = value;
+        return true;
+    }
+    void close_link() override
+    {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            closed = true;
+        }
+        cv.notify_one();
+    }
+
+private:
+    std::mutex m;
+    std::condition_variable cv;
+    unsigned long value = 0;
+    bool full = false;
+    bool closed = false;
+};
+
+// Echo every value back until the master closes the link; false on a sync error
+static bool echo(Link &in, Link &out)
+{
+    unsigned long iter1 = 0, check;
+    while (in.recv(check))
+    {
+        if (check != iter1)
+        {
+            std::cerr << "Slave sync error: expected " << iter1 << ", got " << check << std::endl;
+            return false;
+        }
+        out.send(iter1);
+        iter1++;
+    }
+    return true;
+}
+
+// Timed round trips master -> slave -> master; false on a sync error
+static bool round_trips(Link &out, Link &in, double duration, BenchResult &result)
+{
+    unsigned long check;
+    LatencyRecorder lat; // Round trip master -> slave -> master, every Nth iteration
+    BenchTimer timer;
+    timer.start(duration); // The window opens only after the head start
+    while (!timer.expired())
+    {
+        lat.begin();
+        out.send(iter);
+        if (!in.recv(check))
+            throw PipeException("Master read failed");
+        lat.end();
+        if (check != iter)
+        {
+            std::cerr << "Master sync error: expected " << iter << ", got " << check << std::endl;
+            return false;
+        }
+        iter++;
+    }
+    result.iterations = iter;
+    result.count = static_cast<double>(iter);
+    result.elapsed_ns = timer.stop();
+    lat.report(result);
+    return true;
+}
+
+// CPUs of the master and the slave for a placement, -1 for unpinned; false if the machine lacks it
+static bool pick_cpus(const std::string &placement, int &a, int &b)
+{
+    a = b = -1;
+    if (placement == "any")
+        return true;
+    std::vector<CpuTopo> cpus = cpu_topology();
+    if (cpus.empty())
+        return false;
+    if (placement == "same")
+    {
+        a = b = cpus.front().cpu;
+        return true;
+    }
+    for (const auto &x : cpus)
+    {
+        for (const auto &y : cpus)
+        {
+            bool same_core = x.package == y.package && x.core == y.core;
+            if (x.cpu == y.cpu)
+                continue;
+            // Cross-core stays on one node so the interconnect is not measured as well
+            if ((placement == "smt" && same_core) ||
+                (placement == "cross" && !same_core && x.primary && y.primary && x.node == y.node))
+            {
+                a = x.cpu;
+                b = y.cpu;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static Link *make_link(const std::string &mode)
+{
+    if (mode == "pipe")
+        return new PipeLink();
+    if (mode == "eventfd")
+        return new EventfdLink();
+    if (mode == "futex")
+        return new FutexLink();
+    if (mode == "condvar")
+        return new CondvarLink();
+    return nullptr;
 }
 
 int main(int argc, char *argv[])
 {
     try
     {
-        if (argc != 2)
+        if (argc < 2 || argc > 4)
         {
-            std::cerr << "Usage: " << argv[0] << " duration" << std::endl;
+            std::cerr << "Usage: " << argv[0] << " duration [ process|pipe|eventfd|futex|condvar [ any|same|cross|smt ] ]" << std::endl;
             return 1;
         }
 
-        int duration = std::atoi(argv[1]);
-        unsigned long check;
-
-        int p1[2], p2[2]; // Using array to handle pipe file descriptors
+        double duration = parse_duration(argv[1]);
+        if (duration <= 0)
+        {
+            std::cerr << "Invalid duration: " << argv[1] << std::endl;
+            return 1;
+        }
+        std::string mode = (argc > 2) ? argv[2] : "process";
+        std::string placement = (argc > 3) ? argv[3] : "any";
+        int cpu_master, cpu_slave;
+        if (placement != "any" && placement != "same" && placement != "cross" && placement != "smt")
+        {
+            std::cerr << "Invalid placement: " << placement << std::endl;
+            return 1;
+        }
+        if (!pick_cpus(placement, cpu_master, cpu_slave))
+        {
+            std::cerr << argv[0] << ": no CPU pair for placement " << placement << std::endl;
+            return 1;
+        }
 
-        if (pipe(p1) || pipe(p2))
+        BenchResult result(bench_name(argv[0]), 0, 0);
+        result.tag("mode", mode);
+        result.tag("placement", placement);
+        if (cpu_master >= 0)
         {
-            throw PipeException("Pipe creation failed");
+            result.add("master", cpu_master, "cpus");
+            result.add("slave", cpu_slave, "cpus");
         }
+        pin_thread(cpu_master);
 
-        if (fork())
-        { // Parent process
-            signal(SIGALRM, report);
-            alarm(duration); // Setup alarm
-            usleep(100000);  // Give child a head start
-            close(p1[0]);
-            close(p2[1]);
-            while (true)
+        if (mode != "process")
+        {
+            Link *to_slave = make_link(mode);
+            if (to_slave == nullptr)
             {
-                if (write(p1[1], &iter, sizeof(iter)) != sizeof(iter))
-                {
-                    throw PipeException("Master write failed");
-                }
-                if (read(p2[0], &check, sizeof(check)) != sizeof(check))
+                std::cerr << "Invalid mode: " << mode << std::endl;
+                return 1;
+            }
+            Link *to_master = make_link(mode);
+            process_counters().open(); // before the slave thread starts, so its half is counted too
+            std::atomic<bool> slave_ok{true};
+            std::thread slave([&] {
+                pin_thread(cpu_slave);
+                try
                 {
-                    perror("read");
-                    throw PipeException("Master read failed");
+                    slave_ok = echo(*to_slave, *to_master);
                 }
-                if (check != iter)
+                catch (const PipeException &e)
                 {
-                    std::cerr << "Master sync error: expected " << iter << ", got " << check << std::endl;
-                    return 2;
+                    std::cerr << "Slave error: " << e.what() << std::endl;
+                    slave_ok = false;
                 }
-                iter++;
+            });
+            usleep(100000); // Give the slave a head start
+            bool ok;
+            try
+            {
+                ok = round_trips(*to_slave, *to_master, duration, result);
+            }
+            catch (const PipeException &e)
+            {
+                // The slave thread is still joinable; unwinding past it would terminate
+                std::cerr << "Master error: " << e.what() << std::endl;
+                ok = false;
             }
+            to_slave->close_link();
+            slave.join();
+            delete to_slave;
+            delete to_master;
+            if (!ok || !slave_ok)
+                return 2;
+            emit_result(result);
+            return 0;
+        }
+
+        PipeLink p1, p2; // master -> slave, slave -> master
+
+        process_counters().open(); // before fork(), so the child's half of each round trip is counted too
+        pid_t child = fork();
+        if (child)
+        { // Parent process
+            usleep(100000);  // Give child a head start
+            p1.close_read();
+            p2.close_write();
+            if (!round_trips(p1, p2, duration, result))
+                return 2;
+            emit_result(result);
+            p1.close_write(); // Child sees EOF and exits
+            waitpid(child, nullptr, 0);
+            return 0;
         }
         else
-        {             // Child process
-            sleep(1); // Ensure parent is ready to write
+        {             // Child process, the blocking read() waits for the parent
             try
             {
-                unsigned long iter1 = 0;
-                close(p1[1]);
-                close(p2[0]);
-                while (true)
-                {
-                    ssize_t r = read(p1[0], &check, sizeof(check));
-                    if (r == 0)
-                    {
-                        // std::cerr << "Slave: pipe closed by master" << std::endl;
-                        std::exit(0); // Clean exit
-                    }
-                    if (r != sizeof(check))
-                    {
-                        perror("read");
-                        throw PipeException("Slave read failed");
-                    }
-                    if (check != iter1) {
-                        std::cerr << "Slave sync error: expected " << iter1 << ", got " << check << std::endl;
-                        std::exit(2);
-                    }
-                    if (write(p2[1], &iter1, sizeof(iter1)) != sizeof(check))
-                    {
-                        throw PipeException("Slave write failed");
-                    }
-                    iter1++;
-                }
+                pin_thread(cpu_slave);
+                p1.close_write();
+                p2.close_read();
+                std::exit(echo(p1, p2) ? 0 : 2); // Clean exit on EOF
             }
             catch (const PipeException &e)
             {
@@ -18,28 +18,24 @@
 #include <string>
 #include <array>
 #include "dhry.hpp"
-#include "timeit.cpp"
+#include "timeit.hpp"
+#include "result.hpp"
+#include "kernels.hpp"
 
 using namespace std;
 
-unsigned long Run_Index;
+UB_TLS unsigned long Run_Index;
 
-void report(int sig)
-{
-    cerr << "COUNT|" << Run_Index << "|1|lps" << endl;
-    exit(0);
-}
+/* Global Variables: (per thread in the unixbench binary) */
 
-/* Global Variables: */
-
-Rec_Pointer Ptr_Glob,
-            Next_Ptr_Glob;
-int Int_Glob;
-bool Bool_Glob;
-char Ch_1_Glob,
-     Ch_2_Glob;
-array<int, 50> Arr_1_Glob;
-array<array<int, 50>, 50> Arr_2_Glob;
+UB_TLS Rec_Pointer Ptr_Glob,
+                   Next_Ptr_Glob;
+UB_TLS int Int_Glob;
+UB_TLS bool Bool_Glob;
+UB_TLS char Ch_1_Glob,
+            Ch_2_Glob;
+UB_TLS array<int, 50> Arr_1_Glob;
+UB_TLS array<array<int, 50>, 50> Arr_2_Glob;
 
 Enumeration Func_1(Capital_Letter Ch_1_Par_Val, Capital_Letter Ch_2_Par_Val);
   /* forward declaration necessary since Enumeration may not simply be int */
@@ -83,11 +79,10 @@ extern void Proc_8(std::array<int, 50>& Arr_1_Par_Ref,
             std::array<std::array<int, 50>, 50>& Arr_2_Par_Ref,
             int Int_1_Par_Val, int Int_2_Par_Val);
 
-int main (int argc, char *argv[])
-  /* main program, corresponds to procedures        */
+unsigned long dhry_run(const std::atomic<bool>& stop)
+  /* benchmark body, corresponds to procedures      */
   /* Main and Proc_0 in the Ada version             */
 {
-    int duration;
     One_Fifty Int_1_Loc;
     One_Fifty Int_2_Loc;
     One_Fifty Int_3_Loc;
@@ -114,16 +109,7 @@ int main (int argc, char *argv[])
         /* Warning: With 16-Bit processors and Number_Of_Runs > 32000,  */
         /* overflow may occur for this array element.                   */
 
-
-
-    if (argc != 2) {
-        cerr << "Usage: " << argv[0] << " duration" << endl;
-        exit(1);
-    }
-
-    duration = atoi(argv[1]);
     Run_Index = 0;
-    wake_me(duration, report);
 
     /***************/
     /* Start timer */
@@ -139,7 +125,7 @@ int main (int argc, char *argv[])
 #endif
 #endif /* SELF_TIMED */
 
-    for (Run_Index = 1; ; ++Run_Index)
+    for (Run_Index = 1; !stop.load(std::memory_order_relaxed); ++Run_Index)
     {
 
         Proc_5();
@@ -188,6 +174,7 @@ int main (int argc, char *argv[])
 
     } /* loop "for Run_Index" */
 
+
     /**************/
     /* Stop timer */
     /**************/
@@ -282,8 +269,37 @@ int main (int argc, char *argv[])
         cout << "\n";
     }
 #endif /* SELF_TIMED */
+
+    delete Ptr_Glob;
+    delete Next_Ptr_Glob;
+    return Run_Index - 1;
 }
 
+#ifndef UB_KERNEL
+int main (int argc, char *argv[])
+{
+    double duration;
+
+    if (argc != 2) {
+        cerr << "Usage: " << argv[0] << " duration" << endl;
+        exit(1);
+    }
+
+    duration = parse_duration(argv[1]);
+    if (duration <= 0) {
+        cerr << "Invalid duration: " << argv[1] << endl;
+        exit(1);
+    }
+
+    BenchTimer timer;
+    timer.start(duration);
+    unsigned long runs = dhry_run(bench_stop);
+
+    emit_result(BenchResult(bench_name(argv[0]), runs, timer.stop()));
+    return 0;
+}
+#endif
+
 
 void Proc_1 (Rec_Pointer Ptr_Val_Par)
     /* executed once */
@@ -364,9 +380,6 @@ void Proc_5 (void) {
 }
 
 
-extern int Int_Glob;
-extern char Ch_1_Glob;
-
 void Proc_6(Enumeration Enum_Val_Par, Enumeration* Enum_Ref_Par);
 void Proc_7(One_Fifty Int_1_Par_Val, One_Fifty Int_2_Par_Val, One_Fifty* Int_Par_Ref);
 // void Proc_8(Arr_1_Dim Arr_1_Par_Ref, Arr_2_Dim Arr_2_Par_Ref, int Int_1_Par_Val, int Int_2_Par_Val);
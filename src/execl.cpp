@@ -9,62 +9,107 @@
  * This file is a C++ rewrite of execl.c from the original UnixBench project.
  * Original project address: https://github.com/kdlucas/byte-unixbench/tree/v5.1.3
  *
+ * CMake builds this file several ways, one binary per way of producing the
+ * image, so the cost of exec can be split into its parts:
  *
+ *   execl               static (the original)
+ *   execl-dynamic       dynamically linked, not PIE: ld.so and libc mapping
+ *   execl-pie           dynamically linked PIE: plus relative relocations
+ *   execl-static-pie    static PIE: self-relocation without ld.so
+ *   execl-bigdata       static with a large .data and .bss, every page touched
+ *                       on each exec: page faulting of the image
+ *   execl-libs          dynamic PIE that needs 32 extra shared libraries, each
+ *                       with relocations and a constructor: symbol resolution
  *
+ * Each variant re-execs itself and tags its result with "link".
  */
 
 #include <cstdio>
 #include <cstdlib>
 #include <unistd.h>
 #include <sys/types.h>
-#include <ctime>
 
 #include "big.hpp"  // Import declarations only
+#include "timeit.hpp"
+#include "result.hpp"
+#include "perfcount.hpp"
+
+#ifndef UB_EXECL_LINK
+#define UB_EXECL_LINK "static"
+#endif
 
 char bss[8 * 1024];
 
+#if defined(UB_EXECL_DATA_KB) && defined(UB_EXECL_BSS_KB)
+// Initialised, so it lands in .data and in the file; the other one is zero-fill
+char big_data[UB_EXECL_DATA_KB * 1024] = {1};
+char big_bss[UB_EXECL_BSS_KB * 1024];
+volatile char image_sink;
+
+// Fault in every page of both, as a program initialising its state would
+static void touch_image() {
+    for (size_t i = 0; i < sizeof(big_data); i += 4096)
+        image_sink = big_data[i];
+    for (size_t i = 0; i < sizeof(big_bss); i += 4096)
+        big_bss[i] = 1;
+}
+#else
+static void touch_image() {}
+#endif
+
 int main(int argc, char* argv[]) {
     unsigned long iter = 0;
     char *ptr;
     char *fullpath;
-    int duration;
+    double duration;
     char count_str[32], start_str[32], path_str[256], *dur_str;
-    time_t start_time, this_time;
+    unsigned long long start_time, this_time;   // CLOCK_MONOTONIC ns, valid across exec
 
     if (argc < 2) {
         fprintf(stderr, "Usage: %s duration\n", argv[0]);
         exit(1);
     }
 
-    duration = atoi(argv[1]);
+    duration = parse_duration(argv[1]);
     if (duration > 0) {
         dur_str = argv[1];
         ptr = getenv("UB_BINDIR");
         if (ptr != nullptr) {
-            snprintf(path_str, sizeof(path_str), "%s/execl", ptr);
+            snprintf(path_str, sizeof(path_str), "%s/%s", ptr, bench_name(argv[0]).c_str());
             fullpath = path_str;
         } else {
             fullpath = argv[0];
         }
-        time(&start_time);
+        // Copies launched together wait here for the shared window
+        uint64_t window_start, window_end;
+        start_gate(duration, window_start, window_end);
+        start_time = window_start;
+        // Counters (UB_PERF) stay attached to this task across every exec below
+        process_counters().start();
+        process_counters().export_across_exec();
     } else {
         if (argc < 5) {
             fprintf(stderr, "Not enough arguments for execl'ed invocation\n");
             exit(1);
         }
-        duration = atoi(argv[2]);
+        duration = parse_duration(argv[2]);
         dur_str = argv[2];
-        iter = (unsigned long)atoi(argv[3]);
-        sscanf(argv[4], "%lu", (unsigned long *)&start_time);
+        iter = strtoul(argv[3], nullptr, 10);
+        start_time = strtoull(argv[4], nullptr, 10);
         fullpath = argv[0];
+        process_counters().open();
     }
 
+    touch_image();
     snprintf(count_str, sizeof(count_str), "%lu", ++iter);
-    snprintf(start_str, sizeof(start_str), "%lu", (unsigned long)start_time);
-    time(&this_time);
+    snprintf(start_str, sizeof(start_str), "%llu", start_time);
+    this_time = now_ns();
 
-    if (this_time - start_time >= duration) {
-        fprintf(stderr, "COUNT|%lu|1|lps\n", iter);
+    if (this_time - start_time >= static_cast<unsigned long long>(duration * 1e9)) {
+        process_counters().stop();
+        BenchResult result(bench_name(argv[0]), iter, this_time - start_time);
+        result.tag("link", UB_EXECL_LINK);
+        emit_result(result);
         exit(0);
     }
 
@@ -0,0 +1,40 @@
+/**
+ * @file        execl_lib.cpp
+ * @brief       Filler shared library for the execl-libs variant
+ * @author      rRNA
+ * @version     4.0.0
+ * @date        10-17-2026
+ *
+ * @details
+ * Built UB_EXECL_LIBS times with a different UB_LIB_INDEX. Each copy carries
+ * a table of pointers (relocations the loader must apply), a few exported
+ * functions (dynamic symbols to look up) and a constructor, which is roughly
+ * what a small real-world library costs at exec time.
+ */
+
+#define UB_CAT2(a, b) a##b
+#define UB_CAT(a, b) UB_CAT2(a, b)
+#define UB_SYM(name) UB_CAT(name, UB_LIB_INDEX)
+
+static const char* const names[] = {
+    "alpha", "beta", "gamma", "delta", "epsilon", "zeta", "eta", "theta",
+    "iota", "kappa", "lambda", "mu", "nu", "xi", "omicron", "pi",
+};
+
+extern "C" {
+
+int UB_SYM(ub_execl_lib_value_) = UB_LIB_INDEX;
+
+const char* UB_SYM(ub_execl_lib_name_)(unsigned i) {
+    return names[i % (sizeof(names) / sizeof(names[0]))];
+}
+
+int UB_SYM(ub_execl_lib_sum_)(int a, int b) {
+    return a + b + UB_SYM(ub_execl_lib_value_);
+}
+
+__attribute__((constructor)) static void UB_SYM(ub_execl_lib_init_)() {
+    UB_SYM(ub_execl_lib_value_) += static_cast<int>(sizeof(names) / sizeof(names[0]));
+}
+
+}
@@ -9,8 +9,38 @@
  * This file is a C++ rewrite of fstime.c from the original UnixBench project.
  * Original project address: https://github.com/kdlucas/byte-unixbench/tree/v5.1.3
  *
+ * Besides the original buffered read/write/copy loops, -x selects an I/O
+ * engine that reports IOPS, MB/s and per-I/O latency percentiles:
  *
+ *   -x pattern   read, write, randread or randwrite
+ *   -E engine    psync (pread/pwrite from -q threads, the default) or uring
+ *                (one thread keeping -q I/Os in flight via io_uring)
+ *   -B bytes     block size (default 4096)
+ *   -q depth     queue depth (default 1)
+ *   -s mib       file size in MiB (default 256)
+ *   -D           O_DIRECT with 4 KiB aligned buffers (bypasses the page cache)
+ *   -S n         fdatasync every n writes (per thread), -F to use fsync; with
+ *                either engine writes wait for the sync, and the nth write's
+ *                latency includes it
  *
+ * The file is written and its cache dropped (POSIX_FADV_DONTNEED) before the
+ * window opens, so reads without -D start from the disk but may end up being
+ * served from the page cache.
+ *
+ * -E mmap moves the same file through a shared mapping instead, in passes
+ * that each map the whole file, walk it and unmap it again:
+ *
+ *   -x read      touch one byte per page (-a touch, default) or sum every
+ *                word (-a sum)
+ *   -x write     dirty every page, then msync(MS_SYNC)
+ *   -x copy      memcpy into a second mapped file of the same size, then msync
+ *   -P           MAP_POPULATE (fault everything in at mmap time)
+ *   -A advice    madvise MADV_SEQUENTIAL (seq), MADV_RANDOM or MADV_HUGEPAGE
+ *   -C           drop the page cache before every pass, so pages come from
+ *                the disk (major faults) rather than the cache (minor faults)
+ *
+ * Minor and major page faults over the window (getrusage) are reported per
+ * pass and per MiB next to the MB/s.
  */
 #include <iostream>
 #include <cstdlib>
@@ -19,8 +49,17 @@
 #include <cerrno>
 #include <fcntl.h>
 #include <unistd.h>
-#include <sys/time.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
 #include <sys/stat.h>
+#include <string>
+#include <thread>
+#include <deque>
+#include <vector>
+#include "timeit.hpp"
+#include "result.hpp"
+#include "histogram.hpp"
+#include "uring.hpp"
 
 using namespace std;
 
@@ -45,27 +84,49 @@ char buf[MAX_BUFSIZE];
 int f; // File Descriptors：FNAME0
 int g; // File Descriptors：FNAME1
 
-// Control signal
-int sigalarm = 0;
-
 // Test scores
 long read_score  = 1;
 long write_score = 1;
 long copy_score  = 1;
 
+// Measured window of each phase in nanoseconds (0 if the phase did not run)
+uint64_t read_ns  = 0;
+uint64_t write_ns = 0;
+uint64_t copy_ns  = 0;
+
 //------------------- Function declaration -----
 void stop_count(int single_number);
 void clean_up();
-static double getFloatTime();
-int w_test(int timeSecs);
-int r_test(int timeSecs);
+// Calibration passes run with gated = false; only the scored phase joins the start gate
+int w_test(int timeSecs, bool gated = true);
+int r_test(int timeSecs, bool gated = true);
 int c_test(int timeSecs);
 
+// I/O engine (-x)
+struct IoConfig {
+    string pattern;               // read, write, randread, randwrite
+    string engine = "psync";      // psync, uring, mmap
+    size_t block = 4096;
+    int depth = 1;
+    size_t file_mib = 256;
+    bool direct = false;
+    int sync_every = 0;           // 0: never
+    bool full_fsync = false;
+    // mmap engine
+    string access = "touch";      // read: touch one byte per page or sum every word
+    string advice;                // madvise: seq, random, huge (empty: none)
+    bool populate = false;        // MAP_POPULATE
+    bool cold = false;            // drop the page cache before every pass
+};
+int io_test(const IoConfig& cfg, int timeSecs, const char* prog);
+int mmap_test(const IoConfig& cfg, int timeSecs, const char* prog);
+
 //------------------- Main -------------------
 int main(int argc, char* argv[]) {
     // Default run time and test type
     int seconds = SECONDS;
     char test = 'c';  // Default replication test
+    IoConfig io;
 
     int status = 0;
 
@@ -101,6 +162,58 @@ int main(int argc, char* argv[]) {
                         }
                     }
                     break;
+                case 'x':
+                    if (++i < argc) {
+                        io.pattern = argv[i];
+                    }
+                    break;
+                case 'E':
+                    if (++i < argc) {
+                        io.engine = argv[i];
+                    }
+                    break;
+                case 'B':
+                    if (++i < argc) {
+                        io.block = static_cast<size_t>(std::atol(argv[i]));
+                    }
+                    break;
+                case 'q':
+                    if (++i < argc) {
+                        io.depth = std::atoi(argv[i]);
+                    }
+                    break;
+                case 's':
+                    if (++i < argc) {
+                        io.file_mib = static_cast<size_t>(std::atol(argv[i]));
+                    }
+                    break;
+                case 'D':
+                    io.direct = true;
+                    break;
+                case 'S':
+                    if (++i < argc) {
+                        io.sync_every = std::atoi(argv[i]);
+                    }
+                    break;
+                case 'F':
+                    io.full_fsync = true;
+                    break;
+                case 'a':
+                    if (++i < argc) {
+                        io.access = argv[i];
+                    }
+                    break;
+                case 'A':
+                    if (++i < argc) {
+                        io.advice = argv[i];
+                    }
+                    break;
+                case 'P':
+                    io.populate = true;
+                    break;
+                case 'C':
+                    io.cold = true;
+                    break;
                 default:
                     cerr << "Usage: fstime [-c|-r|-w] [-b <bufsize>] [-m <max_blocks>] [-t <seconds>]" << endl;
                     exit(2);
@@ -124,6 +237,37 @@ int main(int argc, char* argv[]) {
         cerr << "fstime: time must be in range " << 1 << "-" << 3600 << " seconds" << endl;
         exit(3);
     }
+    if (!io.pattern.empty()) {
+        bool mapped = io.engine == "mmap";
+        bool pattern_ok = io.pattern == "read" || io.pattern == "write" ||
+                          (mapped ? io.pattern == "copy"
+                                  : io.pattern == "randread" || io.pattern == "randwrite");
+        if (!pattern_ok || (io.engine != "psync" && io.engine != "uring" && !mapped) ||
+            (io.access != "touch" && io.access != "sum") ||
+            (!io.advice.empty() && io.advice != "seq" && io.advice != "random" && io.advice != "huge")) {
+            cerr << "Usage: fstime -x read|write|randread|randwrite [-E psync|uring] [-B <block>] [-q <depth>]"
+                 << " [-s <file_mib>] [-D] [-S <n> [-F]] [-t <seconds>] [-d <dir>]" << endl;
+            cerr << "       fstime -x read|write|copy -E mmap [-a touch|sum] [-A seq|random|huge] [-P] [-C]"
+                 << " [-s <file_mib>] [-t <seconds>] [-d <dir>]" << endl;
+            exit(2);
+        }
+        if (io.block < 512 || io.block > 64 * 1024 * 1024 || io.depth < 1 || io.depth > 1024 ||
+            io.file_mib < 1 || io.file_mib * 1024 * 1024 < io.block || io.sync_every < 0) {
+            cerr << "fstime: invalid block size, queue depth, file size or sync interval" << endl;
+            exit(3);
+        }
+        if (mapped && (io.direct || io.sync_every)) {
+            cerr << "fstime: -D and -S do not apply to the mmap engine (write passes end in msync)" << endl;
+            exit(3);
+        }
+        if (io.direct && io.block % 4096 != 0) {
+            cerr << "fstime: O_DIRECT needs a block size that is a multiple of 4096" << endl;
+            exit(3);
+        }
+        status = io_test(io, seconds, argv[0]);
+        clean_up();
+        exit(status ? 1 : 0);
+    }
 
     max_buffs = max_blocks * 1024 / bufsize;
     count_per_k = 1024 / COUNTSIZE;
@@ -171,12 +315,12 @@ int main(int argc, char* argv[]) {
             break;
         case 'r':
             // First write 2 seconds of data for calibration
-            w_test(2);
+            w_test(2, false);
             status = r_test(seconds);
             break;
         case 'c':
-            w_test(2);
-            r_test(2);
+            w_test(2, false);
+            r_test(2, false);
             status = c_test(seconds);
             break;
         default:
@@ -189,43 +333,63 @@ int main(int argc, char* argv[]) {
         exit(1);
     }
 
+    // One structured result for the whole run, with every phase as a sub-metric
+    BenchResult result;
+    result.name = bench_name(argv[0]);
+    result.unit = "KBps";
+    result.timebase = 0;
+    // The score stays the best phase of the run, as when the harness took the largest
+    // COUNT line, so -r and -c numbers compare with older results
+    result.count = 0;
+    const long scores[] = {write_score, read_score, copy_score};
+    const uint64_t times[] = {write_ns, read_ns, copy_ns};
+    for (int p = 0; p < 3; ++p) {
+        if (times[p] && scores[p] > result.count) {
+            result.count = scores[p];
+            result.elapsed_ns = times[p];
+        }
+    }
+    result.tag("mode", string(1, test));
+    result.add("bufsize", bufsize, "config");
+    result.add("max_blocks", max_blocks, "config");
+    if (write_ns) {
+        result.add("write_kbps", write_score, "phases");
+        result.add("write_ns", static_cast<double>(write_ns), "phases");
+    }
+    if (read_ns) {
+        result.add("read_kbps", read_score, "phases");
+        result.add("read_ns", static_cast<double>(read_ns), "phases");
+    }
+    if (copy_ns) {
+        result.add("copy_kbps", copy_score, "phases");
+        result.add("copy_ns", static_cast<double>(copy_ns), "phases");
+    }
+    emit_result(result);    // after the per-phase COUNT| lines, so the last one is the score
+
     clean_up();
     exit(0);
 }
 
 //------------------- Helper Functions ----------
 
-// Get the current time (in floating point seconds) using gettimeofday
-static double getFloatTime() {
-    struct timeval t;
-    if (gettimeofday(&t, nullptr) != 0) {
-        perror("gettimeofday");
-        exit(1);
-    }
-    return static_cast<double>(t.tv_sec) + static_cast<double>(t.tv_usec) / 1000000.0;
-}
-
 // Write test: continuously write data to the file within timeSecs seconds and calculate the write score
-int w_test(int timeSecs) {
+int w_test(int timeSecs, bool gated) {
     unsigned long counted = 0L;
     unsigned long tmp;
     long f_blocks;
-    double start, end;
+    double elapsed;
     // Synchronous disk
     sync();
     sleep(2);
     sync();
     sleep(2);
 
-    // Setting the timing signal
-    sigalarm = 0;
-    signal(SIGALRM, stop_count);
-    alarm(timeSecs);
-
-    start = getFloatTime();
+    // Arm the measurement window
+    BenchTimer timer;
+    timer.start(timeSecs, gated);
 
-    while (!sigalarm) {
-        for (f_blocks = 0; f_blocks < max_buffs; ++f_blocks) {
+    while (!timer.expired()) {
+        for (f_blocks = 0; f_blocks < max_buffs && !timer.expired(); ++f_blocks) {
             tmp = write(f, buf, bufsize);
             if (tmp != static_cast<unsigned long>(bufsize)) {
                 if (errno != EINTR) {
@@ -242,22 +406,22 @@ int w_test(int timeSecs) {
     }
 
     // Stop the timer
-    end = getFloatTime();
-    write_score = static_cast<long>( (static_cast<double>(counted)) / ((end - start) * count_per_k) );
-    cout << "Write done: " << counted << " in " << (end - start)
+    write_ns = timer.stop();
+    elapsed = static_cast<double>(write_ns) / 1e9;
+    write_score = static_cast<long>( (static_cast<double>(counted)) / (elapsed * count_per_k) );
+    cout << "Write done: " << counted << " in " << elapsed
          << ", score " << write_score << endl;
 
-    cerr << "COUNT|" << write_score << "|0|KBps" << endl;
-    cerr << "TIME|" << (end - start) << endl;
+    emit_count(BenchResult("fstime", write_score, write_ns, "KBps", 0));
 
     return 0;
 }
 
 // Read test: continuously read data from the file within timeSecs seconds and calculate the read score
-int r_test(int timeSecs) {
+int r_test(int timeSecs, bool gated) {
     unsigned long counted = 0L;
     unsigned long tmp;
-    double start, end;
+    double elapsed;
     // Synchronous disk
     sync();
     sleep(2);
@@ -268,14 +432,11 @@ int r_test(int timeSecs) {
     errno = 0;
     lseek(f, 0L, SEEK_SET);
 
-    // Setting the timing signal
-    sigalarm = 0;
-    signal(SIGALRM, stop_count);
-    alarm(timeSecs);
+    // Arm the measurement window
+    BenchTimer timer;
+    timer.start(timeSecs, gated);
 
-    start = getFloatTime();
-
-    while (!sigalarm) {
+    while (!timer.expired()) {
         tmp = read(f, buf, bufsize);
         if (tmp != static_cast<unsigned long>(bufsize)) {
             switch (errno) {
@@ -298,13 +459,13 @@ int r_test(int timeSecs) {
     }
 
     // Stop the timer
-    end = getFloatTime();
-    read_score = static_cast<long>( (static_cast<double>(counted)) / ((end - start) * count_per_k) );
-    cout << "Read done: " << counted << " in " << (end - start)
+    read_ns = timer.stop();
+    elapsed = static_cast<double>(read_ns) / 1e9;
+    read_score = static_cast<long>( (static_cast<double>(counted)) / (elapsed * count_per_k) );
+    cout << "Read done: " << counted << " in " << elapsed
          << ", score " << read_score << endl;
 
-    cerr << "COUNT|" << read_score << "|0|KBps" << endl;
-    cerr << "TIME|" << (end - start) << endl;
+    emit_count(BenchResult("fstime", read_score, read_ns, "KBps", 0));
 
     return 0;
 }
@@ -313,7 +474,7 @@ int r_test(int timeSecs) {
 int c_test(int timeSecs) {
     unsigned long counted = 0L;
     unsigned long tmp;
-    double start, end;
+    double elapsed;
 
     sync();
     sleep(2);
@@ -324,14 +485,11 @@ int c_test(int timeSecs) {
     errno = 0;
     lseek(f, 0L, SEEK_SET);
 
-    // Setting the timing signal
-    sigalarm = 0;
-    signal(SIGALRM, stop_count);
-    alarm(timeSecs);
-
-    start = getFloatTime();
+    // Arm the measurement window
+    BenchTimer timer;
+    timer.start(timeSecs);
 
-    while (!sigalarm) {
+    while (!timer.expired()) {
         tmp = read(f, buf, bufsize);
         if (tmp != static_cast<unsigned long>(bufsize)) {
             switch (errno) {
@@ -364,20 +522,440 @@ int c_test(int timeSecs) {
     }
 
     // Stop the timer
-    end = getFloatTime();
-    copy_score = static_cast<long>( (static_cast<double>(counted)) / ((end - start) * count_per_k) );
-    cout << "Copy done: " << counted << " in " << (end - start)
+    copy_ns = timer.stop();
+    elapsed = static_cast<double>(copy_ns) / 1e9;
+    copy_score = static_cast<long>( (static_cast<double>(counted)) / (elapsed * count_per_k) );
+    cout << "Copy done: " << counted << " in " << elapsed
          << ", score " << copy_score << endl;
 
-    cerr << "COUNT|" << copy_score << "|0|KBps" << endl;
-    cerr << "TIME|" << (end - start) << endl;
+    emit_count(BenchResult("fstime", copy_score, copy_ns, "KBps", 0));
+
+    return 0;
+}
+
+//------------------- I/O engine ----------------
+
+// One engine thread's view of the file and its share of the work
+struct IoWorker {
+    const IoConfig* cfg;
+    int fd;
+    size_t blocks;                // file size in blocks
+    size_t cursor;                // next block for sequential patterns
+    size_t stride;                // sequential patterns: workers interleave
+    uint64_t rng;
+    char* buf;
+    unsigned long ops = 0;
+    unsigned long syncs = 0;
+    unsigned long writes_since_sync = 0;
+    bool failed = false;
+    LatencyHistogram hist;        // nanoseconds per I/O
+
+    size_t next_block() {
+        if (cfg->pattern == "read" || cfg->pattern == "write") {
+            size_t b = cursor;
+            cursor = (cursor + stride) % blocks;
+            return b;
+        }
+        // xorshift64: cheap enough not to show up next to the I/O
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        return static_cast<size_t>(rng % blocks);
+    }
+};
+
+static bool io_is_write(const IoConfig& cfg) {
+    return cfg.pattern == "write" || cfg.pattern == "randwrite";
+}
+
+static char* io_buffer(size_t bytes) {
+    void* p = nullptr;
+    if (posix_memalign(&p, 4096, bytes) != 0)
+        return nullptr;
+    for (size_t i = 0; i < bytes; ++i)
+        static_cast<char*>(p)[i] = static_cast<char>(i & 0xff);
+    return static_cast<char*>(p);
+}
+
+static bool io_sync(const IoConfig& cfg, int fd) {
+    return (cfg.full_fsync ? fsync(fd) : fdatasync(fd)) == 0;
+}
+
+static void psync_worker(IoWorker* w, const BenchTimer* timer) {
+    const IoConfig& cfg = *w->cfg;
+    bool writing = io_is_write(cfg);
+    while (!timer->expired()) {
+        off_t off = static_cast<off_t>(w->next_block() * cfg.block);
+        uint64_t t0 = now_ns();
+        ssize_t n = writing ? pwrite(w->fd, w->buf, cfg.block, off) : pread(w->fd, w->buf, cfg.block, off);
+        if (n != static_cast<ssize_t>(cfg.block)) {
+            if (n < 0 && errno == EINTR)
+                continue;
+            perror(writing ? "fstime: pwrite" : "fstime: pread");
+            w->failed = true;
+            return;
+        }
+        if (writing && cfg.sync_every && ++w->writes_since_sync >= static_cast<unsigned long>(cfg.sync_every)) {
+            if (!io_sync(cfg, w->fd)) {
+                perror("fstime: sync");
+                w->failed = true;
+                return;
+            }
+            w->writes_since_sync = 0;
+            ++w->syncs;
+        }
+        w->hist.record(now_ns() - t0);
+        ++w->ops;
+    }
+}
 
+// One thread, cfg.depth I/Os in flight; user_data is the slot, SYNC_SLOT marks a sync
+static bool uring_run(IoWorker& w, Uring& ring, const BenchTimer& timer) {
+    const IoConfig& cfg = *w.cfg;
+    constexpr uint64_t SYNC_SLOT = ~0ULL;
+    bool writing = io_is_write(cfg);
+    vector<uint64_t> issued(cfg.depth);
+    vector<char*> bufs(cfg.depth);
+    for (int i = 0; i < cfg.depth; ++i)
+        bufs[i] = w.buf + static_cast<size_t>(i) * cfg.block;
+
+    auto queue_io = [&](int slot) {
+        io_uring_sqe* sqe = ring.get_sqe();
+        sqe->opcode = writing ? IORING_OP_WRITE : IORING_OP_READ;
+        sqe->fd = w.fd;
+        sqe->addr = reinterpret_cast<uintptr_t>(bufs[slot]);
+        sqe->len = static_cast<unsigned>(cfg.block);
+        sqe->off = w.next_block() * cfg.block;
+        sqe->user_data = static_cast<uint64_t>(slot);
+        issued[slot] = now_ns();
+    };
+
+    // Every sync_every-th write completion queues one FSYNC and, as with psync, new
+    // writes are held until it completes. That write's latency runs until its sync
+    // is done; a sync owed while another is in flight follows right after it.
+    deque<uint64_t> sync_waiters;   // issue times of the writes that owe a sync
+    vector<int> parked;             // slots held back while a sync is in flight
+    bool sync_pending = false;
+    auto queue_sync = [&]() {
+        io_uring_sqe* sqe = ring.get_sqe();
+        sqe->opcode = IORING_OP_FSYNC;
+        sqe->fd = w.fd;
+        sqe->fsync_flags = cfg.full_fsync ? 0 : IORING_FSYNC_DATASYNC;
+        sqe->user_data = SYNC_SLOT;
+        sync_pending = true;
+    };
+
+    for (int i = 0; i < cfg.depth; ++i)
+        queue_io(i);
+    int inflight = cfg.depth;
+    if (ring.submit() < 0)
+        return false;
+
+    while (inflight > 0 || sync_pending) {
+        io_uring_cqe* cqe;
+        if (ring.wait_cqe(&cqe) < 0)
+            return false;
+        uint64_t slot = cqe->user_data;
+        int res = cqe->res;
+        ring.cqe_seen();
+        if (slot == SYNC_SLOT) {
+            if (res < 0) {
+                cerr << "fstime: io_uring sync: " << strerror(-res) << endl;
+                return false;
+            }
+            sync_pending = false;
+            ++w.syncs;
+            w.hist.record(now_ns() - sync_waiters.front());
+            sync_waiters.pop_front();
+            if (!sync_waiters.empty()) {
+                queue_sync();
+            } else if (!timer.expired()) {
+                for (int p : parked)
+                    queue_io(p);
+                inflight += static_cast<int>(parked.size());
+                parked.clear();
+            }
+            if (ring.submit() < 0)
+                return false;
+            continue;
+        }
+        --inflight;
+        if (res != static_cast<int>(cfg.block)) {
+            cerr << "fstime: io_uring " << (writing ? "write" : "read") << ": "
+                 << (res < 0 ? strerror(-res) : "short transfer") << endl;
+            return false;
+        }
+        ++w.ops;
+        if (writing && cfg.sync_every && ++w.writes_since_sync >= static_cast<unsigned long>(cfg.sync_every)) {
+            w.writes_since_sync = 0;
+            sync_waiters.push_back(issued[slot]);
+            if (!sync_pending)
+                queue_sync();
+        } else {
+            w.hist.record(now_ns() - issued[slot]);
+        }
+        // Keep the queue full until the window closes, then drain
+        if (sync_pending) {
+            parked.push_back(static_cast<int>(slot));
+        } else if (!timer.expired()) {
+            queue_io(static_cast<int>(slot));
+            ++inflight;
+        }
+        if (ring.submit() < 0)
+            return false;
+    }
+    return true;
+}
+
+// Lay the file out in full so reads and overwrites hit allocated blocks, then drop it
+// from the page cache
+static bool io_prepare(const char* name, size_t file_bytes) {
+    char* fill = io_buffer(1024 * 1024);
+    int fd = open(name, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0 || fill == nullptr) {
+        perror("fstime: open");
+        return false;
+    }
+    for (size_t done = 0; done < file_bytes;) {
+        size_t n = std::min<size_t>(1024 * 1024, file_bytes - done);
+        if (write(fd, fill, n) != static_cast<ssize_t>(n)) {
+            perror("fstime: write");
+            close(fd);
+            free(fill);
+            return false;
+        }
+        done += n;
+    }
+    fsync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+    free(fill);
+    return true;
+}
+
+int io_test(const IoConfig& cfg, int timeSecs, const char* prog) {
+    if (cfg.engine == "mmap")
+        return mmap_test(cfg, timeSecs, prog);
+    size_t file_bytes = cfg.file_mib * 1024 * 1024 / cfg.block * cfg.block;
+    size_t blocks = file_bytes / cfg.block;
+
+    if (!io_prepare(FNAME0, file_bytes))
+        return -1;
+    int fd = open(FNAME0, O_RDWR | (cfg.direct ? O_DIRECT : 0));
+    if (fd < 0) {
+        perror(cfg.direct ? "fstime: open O_DIRECT" : "fstime: open");
+        return -1;
+    }
+
+    int threads = (cfg.engine == "psync") ? cfg.depth : 1;
+    vector<IoWorker> workers(threads);
+    for (int i = 0; i < threads; ++i) {
+        IoWorker& w = workers[i];
+        w.cfg = &cfg;
+        w.fd = fd;
+        w.blocks = blocks;
+        w.cursor = static_cast<size_t>(i) % blocks;
+        w.stride = static_cast<size_t>(threads);
+        w.rng = 0x9e3779b97f4a7c15ULL * static_cast<uint64_t>(i + 1);
+        w.buf = io_buffer(cfg.block * (cfg.engine == "uring" ? cfg.depth : 1));
+        if (w.buf == nullptr) {
+            cerr << "fstime: cannot allocate I/O buffers" << endl;
+            return -1;
+        }
+    }
+
+    Uring ring;
+    if (cfg.engine == "uring") {
+        int err = ring.init(static_cast<unsigned>(cfg.depth) + 1);
+        if (err < 0) {
+            cerr << "fstime: io_uring_setup: " << strerror(-err) << endl;
+            return -1;
+        }
+    }
+
+    // Arm the measurement window
+    BenchTimer timer;
+    timer.start(timeSecs);
+    bool ok = true;
+    if (cfg.engine == "uring") {
+        ok = uring_run(workers[0], ring, timer);
+    } else {
+        vector<std::thread> pool;
+        for (int i = 1; i < threads; ++i)
+            pool.emplace_back(psync_worker, &workers[i], &timer);
+        psync_worker(&workers[0], &timer);
+        for (auto& t : pool)
+            t.join();
+    }
+    uint64_t ns = timer.stop();
+    close(fd);
+
+    unsigned long ops = 0, syncs = 0;
+    LatencyHistogram hist;
+    for (auto& w : workers) {
+        ok = ok && !w.failed;
+        ops += w.ops;
+        syncs += w.syncs;
+        hist.merge(w.hist);
+        free(w.buf);
+    }
+    if (!ok)
+        return -1;
+
+    double secs = static_cast<double>(ns) / 1e9;
+    double iops = static_cast<double>(ops) / secs;
+    double mbps = static_cast<double>(ops) * static_cast<double>(cfg.block) / secs / 1e6;
+    cout << cfg.pattern << " " << cfg.engine << " bs " << cfg.block << " qd " << cfg.depth
+         << (cfg.direct ? " direct" : " buffered") << ": " << static_cast<long>(iops) << " IOPS, "
+         << mbps << " MB/s, p99 " << hist.percentile(0.99) / 1000.0 << " us" << endl;
+
+    BenchResult result(bench_name(prog), ops, ns, "iops");
+    result.tag("pattern", cfg.pattern);
+    result.tag("engine", cfg.engine);
+    result.tag("cache", cfg.direct ? "direct" : "buffered");
+    if (cfg.sync_every)
+        result.tag("sync", cfg.full_fsync ? "fsync" : "fdatasync");
+    result.add("block_bytes", static_cast<double>(cfg.block), "config");
+    result.add("queue_depth", cfg.depth, "config");
+    result.add("file_bytes", static_cast<double>(file_bytes), "config");
+    result.add("sync_every", cfg.sync_every, "config");
+    result.add("iops", iops, "io");
+    result.add("mbps", mbps, "io");
+    result.add("syncs", static_cast<double>(syncs), "io");
+    report_histogram(result, hist, 1.0);
+    emit_result(result);
+    return 0;
+}
+
+//------------------- mmap engine ----------------
+
+constexpr size_t MMAP_CHUNK = 1024 * 1024;   // the window is checked between chunks
+
+static void* map_file(int fd, size_t bytes, bool writable, const IoConfig& cfg) {
+    int prot = PROT_READ | (writable ? PROT_WRITE : 0);
+    void* p = mmap(nullptr, bytes, prot, MAP_SHARED | (cfg.populate ? MAP_POPULATE : 0), fd, 0);
+    if (p == MAP_FAILED)
+        return nullptr;
+    if (cfg.advice == "seq")
+        madvise(p, bytes, MADV_SEQUENTIAL);
+    else if (cfg.advice == "random")
+        madvise(p, bytes, MADV_RANDOM);
+    else if (cfg.advice == "huge")
+        madvise(p, bytes, MADV_HUGEPAGE);   // only honoured where the filesystem supports large folios
+    return p;
+}
+
+int mmap_test(const IoConfig& cfg, int timeSecs, const char* prog) {
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t file_bytes = cfg.file_mib * 1024 * 1024;
+    bool copying = cfg.pattern == "copy";
+    bool writing = cfg.pattern == "write";
+
+    if (!io_prepare(FNAME0, file_bytes) || (copying && !io_prepare(FNAME1, file_bytes)))
+        return -1;
+    int src = open(FNAME0, O_RDWR);
+    int dst = copying ? open(FNAME1, O_RDWR) : -1;
+    if (src < 0 || (copying && dst < 0)) {
+        perror("fstime: open");
+        return -1;
+    }
+
+    struct rusage ru0, ru1;
+    unsigned long passes = 0;
+    size_t bytes = 0;
+    uint64_t sum = 0;
+    unsigned char stamp = 0;
+    bool ok = true;
+
+    BenchTimer timer;
+    timer.start(timeSecs);
+    getrusage(RUSAGE_SELF, &ru0);
+    while (ok && !timer.expired()) {
+        if (cfg.cold) {
+            posix_fadvise(src, 0, 0, POSIX_FADV_DONTNEED);
+            if (copying)
+                posix_fadvise(dst, 0, 0, POSIX_FADV_DONTNEED);
+        }
+        char* from = static_cast<char*>(map_file(src, file_bytes, writing, cfg));
+        char* to = copying ? static_cast<char*>(map_file(dst, file_bytes, true, cfg)) : nullptr;
+        if (from == nullptr || (copying && to == nullptr)) {
+            perror("fstime: mmap");
+            ok = false;
+            break;
+        }
+        ++stamp;
+        size_t done = 0;
+        for (; done < file_bytes && !timer.expired(); done += MMAP_CHUNK) {
+            size_t n = std::min(MMAP_CHUNK, file_bytes - done);
+            char* p = from + done;
+            if (copying) {
+                memcpy(to + done, p, n);
+            } else if (writing) {
+                for (size_t off = 0; off < n; off += page)
+                    memset(p + off, stamp, page);
+            } else if (cfg.access == "sum") {
+                const uint64_t* w = reinterpret_cast<const uint64_t*>(p);
+                for (size_t k = 0; k < n / sizeof(uint64_t); ++k)
+                    sum += w[k];
+            } else {
+                for (size_t off = 0; off < n; off += page)
+                    sum += static_cast<unsigned char>(p[off]);
+            }
+        }
+        done = std::min(done, file_bytes);
+        // Dirty pages are part of the pass: write them back before the next one
+        if ((writing && msync(from, done, MS_SYNC) != 0) || (copying && msync(to, done, MS_SYNC) != 0)) {
+            perror("fstime: msync");
+            ok = false;
+        }
+        munmap(from, file_bytes);
+        if (to)
+            munmap(to, file_bytes);
+        bytes += done;
+        if (done == file_bytes)
+            ++passes;
+    }
+    getrusage(RUSAGE_SELF, &ru1);
+    uint64_t ns = timer.stop();
+    close(src);
+    if (dst >= 0)
+        close(dst);
+    if (!ok)
+        return -1;
+
+    double secs = static_cast<double>(ns) / 1e9;
+    double mib = static_cast<double>(bytes) / (1024.0 * 1024.0);
+    double minor = static_cast<double>(ru1.ru_minflt - ru0.ru_minflt);
+    double major = static_cast<double>(ru1.ru_majflt - ru0.ru_majflt);
+    double mbps = static_cast<double>(bytes) / secs / 1e6;
+    cout << cfg.pattern << " mmap" << (cfg.pattern == "read" ? " " + cfg.access : string())
+         << (cfg.populate ? " populate" : "") << (cfg.cold ? " cold" : "") << ": " << mbps << " MB/s, "
+         << minor << " minor / " << major << " major faults (checksum " << (sum & 0xffff) << ")" << endl;
+
+    BenchResult result(bench_name(prog), bytes / page, ns, "pages");
+    result.tag("pattern", cfg.pattern);
+    result.tag("engine", "mmap");
+    result.tag("cache", cfg.cold ? "cold" : "warm");
+    if (cfg.pattern == "read")
+        result.tag("access", cfg.access);
+    result.tag("advice", cfg.advice.empty() ? "none" : cfg.advice);
+    result.tag("populate", cfg.populate ? "yes" : "no");
+    result.add("file_bytes", static_cast<double>(file_bytes), "config");
+    result.add("page_bytes", static_cast<double>(page), "config");
+    result.add("mbps", mbps, "io");
+    result.add("bytes", static_cast<double>(bytes), "io");
+    result.add("passes", static_cast<double>(passes), "io");
+    result.add("minor", minor, "faults");
+    result.add("major", major, "faults");
+    result.add("per_mib", mib > 0 ? (minor + major) / mib : 0.0, "faults");
+    result.add("per_pass", passes ? (minor + major) / static_cast<double>(passes) : 0.0, "faults");
+    emit_result(result);
     return 0;
 }
 
-// stop_count: called by SIGALRM signal, sets sigalarm flag
+// stop_count: closes the measurement window early (e.g. after an interrupted transfer)
 void stop_count(int single_number) {
-    sigalarm = 1;
+    bench_stop.store(true, std::memory_order_relaxed);
 }
 
 // clean_up: delete test files
@@ -15,8 +15,9 @@
 
 #include <iostream>
 #include <cstdlib>
-#include "timeit.cpp"  // The wake_me function is defined in timeit.cpp
-#include <csignal>
+#include "timeit.hpp"  // BenchTimer lives in the ubcommon library
+#include "result.hpp"
+#include "kernels.hpp"
 
 using namespace std;
 
@@ -25,17 +26,10 @@ inline int other(int i, int j) {
     return 6 - (i + j);
 }
 
-// Global variables
-unsigned long iter = 0;
-int num[4] = {0};  // Initialized to 0
-long cnt = 0;
+// Global variables (per thread in the unixbench binary)
+UB_TLS int num[4] = {0};  // Initialized to 0
 
-void report(int sig) {
-    std::cerr << "COUNT|" << iter << "|1|lps" << std::endl;
-    exit(0);
-}
-
-void mov(int n, int f, int t) {
+static void mov(int n, int f, int t) {
     if(n == 1) {
         num[f]--;
         num[t]++;
@@ -47,28 +41,42 @@ void mov(int n, int f, int t) {
     mov(n - 1, o, t);
 }
 
+unsigned long hanoi_run(int disks, const std::atomic<bool>& stop) {
+    unsigned long iter = 0;
+    num[1] = disks;
+
+    while(!stop.load(std::memory_order_relaxed)) {
+        mov(disks, 1, 3);
+        iter++;
+    }
+    return iter;
+}
+
+#ifndef UB_KERNEL
 int main(int argc, char* argv[]) {
     int disk = 10;  // The default number of disks is 10
-    int duration;
+    double duration;
 
     if(argc < 2) {
         cerr << "Usage: " << argv[0] << " duration [disks]" << endl;
         exit(1);
     }
 
-    duration = atoi(argv[1]);
+    duration = parse_duration(argv[1]);
+    if(duration <= 0) {
+        cerr << "Invalid duration: " << argv[1] << endl;
+        exit(1);
+    }
     if(argc > 2) {
         disk = atoi(argv[2]);
     }
-    num[1] = disk;
-
-    // Set a timer and call the report function when the duration is reached
-    wake_me(duration, report);
 
-    while(true) {
-        mov(disk, 1, 3);
-        iter++;
-    }
+    // Arm the measurement window; the loop stops once the timer sets the stop flag
+    BenchTimer timer;
+    timer.start(duration);
+    unsigned long iter = hanoi_run(disk, bench_stop);
 
+    emit_result(BenchResult(bench_name(argv[0]), iter, timer.stop()));
     return 0;
-}
\ No newline at end of file
+}
+#endif
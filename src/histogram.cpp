@@ -0,0 +1,88 @@
+/**
+ * @file        histogram.cpp
+ * @brief       Log-linear latency histogram and sampling recorder
+ * @author      rRNA
+ * @version     4.0.0
+ * @date        10-17-2026
+ *
+ * @details
+ * Samples are kept in clock ticks and converted to nanoseconds only when the
+ * result is reported, so the measured loop never touches floating point.
+ */
+
+#include "histogram.hpp"
+#include "result.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+uint64_t LatencyHistogram::highest_in(size_t idx) {
+    if (idx < SUB_COUNT)
+        return idx;
+    int shift = static_cast<int>(idx / SUB_COUNT) - 1;
+    uint64_t lowest = (idx % SUB_COUNT + SUB_COUNT) << shift;
+    return lowest + (1ULL << shift) - 1;
+}
+
+uint64_t LatencyHistogram::percentile(double q) const {
+    if (total == 0)
+        return 0;
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total) + 0.5);
+    if (rank < 1)
+        rank = 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= rank)
+            return highest_in(i) < hi ? highest_in(i) : hi;
+    }
+    return hi;
+}
+
+LatencyRecorder::LatencyRecorder() {
+    const char* sample = std::getenv("UB_LAT_SAMPLE");
+    if (sample == nullptr)
+        return;
+    long n = std::strtol(sample, nullptr, 10);
+    if (n <= 0)
+        return;
+    every = static_cast<uint64_t>(n);
+    const char* clk = std::getenv("UB_LAT_CLOCK");
+    raw = (clk != nullptr && std::strcmp(clk, "raw") == 0);
+    // Calibrate now, outside the measurement window
+    ns_per_tick = raw ? 1.0 : tsc_ns_per_tick();
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < counts.size(); ++i)
+        counts[i] += other.counts[i];
+    total += other.total;
+    sum += other.sum;
+    if (other.lo < lo)
+        lo = other.lo;
+    if (other.hi > hi)
+        hi = other.hi;
+}
+
+void report_histogram(BenchResult& r, const LatencyHistogram& h, double ns_per_tick,
+                      uint64_t sample_every, const char* group) {
+    auto ns = [ns_per_tick](uint64_t ticks) { return std::round(static_cast<double>(ticks) * ns_per_tick); };
+    r.add("samples", static_cast<double>(h.samples()), group);
+    if (sample_every)
+        r.add("sample_every", static_cast<double>(sample_every), group);
+    r.add("min_ns", ns(h.min()), group);
+    r.add("mean_ns", std::round(h.mean() * ns_per_tick), group);
+    r.add("p50_ns", ns(h.percentile(0.50)), group);
+    r.add("p90_ns", ns(h.percentile(0.90)), group);
+    r.add("p99_ns", ns(h.percentile(0.99)), group);
+    r.add("p999_ns", ns(h.percentile(0.999)), group);
+    r.add("max_ns", ns(h.max()), group);
+}
+
+void LatencyRecorder::report(BenchResult& r) const {
+    if (!enabled())
+        return;
+    r.tag("lat_clock", raw ? "monotonic_raw" : "tsc");
+    report_histogram(r, hist, ns_per_tick, every);
+}
@@ -0,0 +1,129 @@
+/**
+ * @file        histogram.hpp
+ * @brief       Log-linear latency histogram and sampling recorder
+ * @author      rRNA
+ * @version     4.0.0
+ * @date        10-17-2026
+ *
+ * @details
+ * The throughput tests report iterations per second, which hides the tail.
+ * LatencyRecorder times every Nth iteration of a measured loop and files the
+ * sample into an HDR-style histogram: values below 2^SUB_BITS ticks get their
+ * own bucket, larger values share 2^SUB_BITS linear buckets per power of two,
+ * so every bucket is within ~3% of the values it holds and recording is a
+ * couple of shifts and an increment.
+ *
+ * Sampling is off unless UB_LAT_SAMPLE=N is set (N = sample every Nth
+ * iteration, 1 = every iteration). UB_LAT_CLOCK=raw switches the clock from
+ * the cycle counter to CLOCK_MONOTONIC_RAW, for hosts without an invariant TSC.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <vector>
+
+#include "timeit.hpp"
+
+struct BenchResult;
+
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BITS = 5;
+    static constexpr uint64_t SUB_COUNT = 1ULL << SUB_BITS;
+    static constexpr size_t BUCKETS = (64 - SUB_BITS + 1) * SUB_COUNT;
+
+    LatencyHistogram() : counts(BUCKETS, 0) {}
+
+    void record(uint64_t v) {
+        ++counts[index(v)];
+        ++total;
+        sum += v;
+        if (v < lo)
+            lo = v;
+        if (v > hi)
+            hi = v;
+    }
+
+    uint64_t samples() const { return total; }
+    uint64_t min() const { return total ? lo : 0; }
+    uint64_t max() const { return hi; }
+    double mean() const { return total ? static_cast<double>(sum) / static_cast<double>(total) : 0; }
+
+    // Highest value equivalent to the bucket holding the q-th quantile (0 < q <= 1), capped at max()
+    uint64_t percentile(double q) const;
+
+    // Fold another histogram (e.g. of another thread) into this one
+    void merge(const LatencyHistogram& other);
+
+private:
+    static size_t index(uint64_t v) {
+        if (v < SUB_COUNT)
+            return static_cast<size_t>(v);
+        int shift = 63 - __builtin_clzll(v) - SUB_BITS;
+        return static_cast<size_t>((shift + 1) * SUB_COUNT + ((v >> shift) - SUB_COUNT));
+    }
+    static uint64_t highest_in(size_t idx);
+
+    std::vector<uint64_t> counts;
+    uint64_t total = 0;
+    uint64_t sum = 0;
+    uint64_t lo = UINT64_MAX;
+    uint64_t hi = 0;
+};
+
+// Adds samples, min/mean/p50/p90/p99/p99.9/max in nanoseconds to `group` of r.
+// Values are in ticks of ns_per_tick nanoseconds; sample_every is reported when non-zero.
+void report_histogram(BenchResult& r, const LatencyHistogram& h, double ns_per_tick,
+                      uint64_t sample_every = 0, const char* group = "latency");
+
+// Times one in every N iterations of a measured loop:
+//
+//     LatencyRecorder lat;
+//     while (!timer.expired()) { lat.begin(); ...one iteration...; lat.end(); }
+//     lat.report(result);
+//
+// When sampling is off begin()/end() cost one predictable branch each.
+class LatencyRecorder {
+public:
+    LatencyRecorder();
+
+    bool enabled() const { return every != 0; }
+
+    void begin() {
+        if (every && ++skipped >= every) {
+            skipped = 0;
+            armed = true;
+            stamp = clock();
+        }
+    }
+
+    void end() {
+        if (armed) {
+            hist.record(clock() - stamp);
+            armed = false;
+        }
+    }
+
+    // Adds min/mean/p50/p90/p99/p99.9/max in nanoseconds as the "latency" group
+    void report(BenchResult& r) const;
+
+private:
+    uint64_t clock() const {
+        if (raw) {
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+            return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+        }
+        return tsc_now();
+    }
+
+    LatencyHistogram hist;
+    uint64_t every = 0;
+    uint64_t skipped = 0;
+    uint64_t stamp = 0;
+    double ns_per_tick = 1.0;
+    bool raw = false;
+    bool armed = false;
+};
@@ -0,0 +1,44 @@
+/**
+ * @file        kernels.hpp
+ * @brief       CPU benchmark kernels shared by the standalone tests and the unixbench binary
+ * @author      rRNA
+ * @version     4.0.0
+ * @date        10-17-2026
+ *
+ * @details
+ * Each kernel runs until its stop flag is set and returns the number of
+ * completed iterations. The standalone programs pass bench_stop (driven by
+ * BenchTimer); the multi-call unixbench binary runs the same kernels on
+ * pinned std::thread workers.
+ *
+ * When compiled with UB_KERNEL the sources drop their main() and their
+ * per-benchmark globals become thread_local, so copies do not share state.
+ */
+
+#pragma once
+
+#include <atomic>
+
+#ifdef UB_KERNEL
+#define UB_TLS thread_local
+#else
+#define UB_TLS
+#endif
+
+// Dhrystone 2 (dhry.cpp), one iteration is one pass through the Dhrystone loop
+unsigned long dhry_run(const std::atomic<bool>& stop);
+
+// Tower of Hanoi (hanoi.cpp), one iteration moves all disks from peg 1 to peg 3
+unsigned long hanoi_run(int disks, const std::atomic<bool>& stop);
+
+// Whetstone (whets.cpp), one iteration is one pass of the eight sections with x100 = 100
+unsigned long whetstone_run(const std::atomic<bool>& stop);
+
+// Arithmetic variants (arith.cpp), compiled once per datum type
+unsigned long arith_run_arithoh(const std::atomic<bool>& stop);
+unsigned long arith_run_register(const std::atomic<bool>& stop);
+unsigned long arith_run_short(const std::atomic<bool>& stop);
+unsigned long arith_run_int(const std::atomic<bool>& stop);
+unsigned long arith_run_long(const std::atomic<bool>& stop);
+unsigned long arith_run_float(const std::atomic<bool>& stop);
+unsigned long arith_run_double(const std::atomic<bool>& stop);
@@ -17,8 +17,8 @@
 #include <cstdlib>
 #include <unistd.h>
 #include <sys/wait.h>
-#include <csignal>
-#include "timeit.cpp"  // The wake_me function is defined in timeit.cpp
+#include "timeit.hpp"  // BenchTimer lives in the ubcommon library
+#include "result.hpp"
 
 using namespace std;
 
@@ -27,16 +27,9 @@ unsigned long iter = 0;
 char* cmd_argv[28]; // Save commands and parameters
 int  cmd_argc = 0;
 
-// Timer signal processing function, when the duration is reached,
-// call report() to output the number of iterations and then exit
-void report(int sig) {
-    // Make sure the output goes to stdout so Run.py can capture it
-    cout << "COUNT|" << iter << "|60|lpm" << endl;
-    exit(0);
-}
-
 int main(int argc, char* argv[]) {
-    int slave, count, duration;
+    int slave, count;
+    double duration;
     int status;
 
     // Parameter check: requires at least two parameters: duration and command
@@ -47,8 +40,8 @@ int main(int argc, char* argv[]) {
     }
 
     // Parsing duration parameters
-    duration = atoi(argv[1]);
-    if (duration < 1) {
+    duration = parse_duration(argv[1]);
+    if (duration <= 0) {
         cerr << "Usage: " << argv[0] << " duration command [args..]" << endl;
         cerr << "  duration in seconds" << endl;
         exit(1);
@@ -71,12 +64,13 @@ int main(int argc, char* argv[]) {
 #endif
 
     iter = 0;
-    // Set a timer and call the report() function after duration seconds
-    wake_me(duration, report);
+    // Arm the measurement window; the running command is always allowed to finish
+    BenchTimer timer;
+    timer.start(duration);
 
     // The main loop continuously forks to create child processes to
     // execute the specified commands
-    while (true) {
+    while (!timer.expired()) {
         slave = fork();
         if (slave == 0) {
             // Subprocess: Execute command
@@ -103,5 +97,8 @@ int main(int argc, char* argv[]) {
         iter++;
     }
 
+    BenchResult result(bench_name(argv[0]), iter, timer.stop(), "lpm", 60);
+    result.tag("command", cmd_argv[0]);
+    emit_result(result);
     return 0;
 }
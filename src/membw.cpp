@@ -0,0 +1,418 @@
+/**
+ * @file        membw.cpp
+ * @brief       Memory bandwidth benchmark (STREAM copy/scale/add/triad)
+ * @author      rRNA
+ * @version     4.0.0
+ * @date        10-17-2026
+ *
+ * @details
+ * The other CPU tests (dhry, whetstone, arith) run out of registers and L1, so
+ * they say nothing about the memory system. membw runs the four STREAM kernels
+ *
+ *   copy:  c[i] = a[i]            scale: b[i] = s * c[i]
+ *   add:   c[i] = a[i] + b[i]     triad: a[i] = b[i] + s * c[i]
+ *
+ * over a sweep of working-set sizes from L1 to several times the LLC, for each
+ * instruction set the CPU supports (scalar, SSE2, AVX2, AVX-512, each also with
+ * non-temporal stores), chosen at runtime with CPUID. Every copy runs on its
+ * own pinned thread with its own first-touched arrays, and all copies measure
+ * the same window. Bandwidth is counted the STREAM way (bytes read + bytes
+ * written, MB = 10^6 bytes).
+ *
+ * Each sweep point is reported as a JSON line. The final COUNT| result is the
+ * best triad bandwidth at the largest size, which is what the index uses. With
+ * -S only that point is measured: a short probe at the largest size picks the
+ * instruction set, and the scored point then gets the whole duration instead of
+ * one slice of the sweep.
+ *
+ * Usage:
+ *   membw [-t threads] [-n | -p policy] [-k kernels] [-i isas] [-m max_kib] [-S] duration
+ */
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define UB_X86 1
+#endif
+
+#include "timeit.hpp"
+#include "result.hpp"
+#include "topology.hpp"
+#include "workpool.hpp"
+
+using namespace std;
+
+struct Arrays {
+    double* a;
+    double* b;
+    double* c;
+};
+
+using StreamFn = void (*)(const Arrays& v, size_t n, double s);
+
+// ---------------------------------------------------------------- scalar ----
+// Vectorization is disabled so "scalar" stays scalar under -O3 -march=native
+#if defined(__clang__)
+#define UB_SCALAR
+#define UB_SCALAR_LOOP _Pragma("clang loop vectorize(disable) interleave(disable)")
+#elif defined(__GNUC__)
+#define UB_SCALAR __attribute__((optimize("no-tree-vectorize")))
+#define UB_SCALAR_LOOP
+#else
+#define UB_SCALAR
+#define UB_SCALAR_LOOP
+#endif
+
+UB_SCALAR static void copy_scalar(const Arrays& v, size_t n, double) {
+    UB_SCALAR_LOOP
+    for (size_t i = 0; i < n; ++i)
+        v.c[i] = v.a[i];
+}
+UB_SCALAR static void scale_scalar(const Arrays& v, size_t n, double s) {
+    UB_SCALAR_LOOP
+    for (size_t i = 0; i < n; ++i)
+        v.b[i] = s * v.c[i];
+}
+UB_SCALAR static void add_scalar(const Arrays& v, size_t n, double) {
+    UB_SCALAR_LOOP
+    for (size_t i = 0; i < n; ++i)
+        v.c[i] = v.a[i] + v.b[i];
+}
+UB_SCALAR static void triad_scalar(const Arrays& v, size_t n, double s) {
+    UB_SCALAR_LOOP
+    for (size_t i = 0; i < n; ++i)
+        v.a[i] = v.b[i] + s * v.c[i];
+}
+
+// ------------------------------------------------------------------ SIMD ----
+// One macro instance per instruction set and store flavour. STORE is either the
+// aligned store or the streaming (non-temporal) store; n is a multiple of 64.
+#ifdef UB_X86
+#define UB_STREAM_KERNELS(isa, TGT, VEC, W, LOAD, STORE, SET1, ADD, MUL)          \
+    __attribute__((target(TGT))) static void copy_##isa(const Arrays& v, size_t n, double) { \
+        for (size_t i = 0; i < n; i += W)                                            \
+            STORE(v.c + i, LOAD(v.a + i));                                           \
+    }                                                                                \
+    __attribute__((target(TGT))) static void scale_##isa(const Arrays& v, size_t n, double s) { \
+        VEC k = SET1(s);                                                             \
+        for (size_t i = 0; i < n; i += W)                                            \
+            STORE(v.b + i, MUL(k, LOAD(v.c + i)));                                   \
+    }                                                                                \
+    __attribute__((target(TGT))) static void add_##isa(const Arrays& v, size_t n, double) { \
+        for (size_t i = 0; i < n; i += W)                                            \
+            STORE(v.c + i, ADD(LOAD(v.a + i), LOAD(v.b + i)));                       \
+    }                                                                                \
+    __attribute__((target(TGT))) static void triad_##isa(const Arrays& v, size_t n, double s) { \
+        VEC k = SET1(s);                                                             \
+        for (size_t i = 0; i < n; i += W)                                            \
+            STORE(v.a + i, ADD(LOAD(v.b + i), MUL(k, LOAD(v.c + i))));               \
+    }
+
+UB_STREAM_KERNELS(sse2,      "sse2",    __m128d, 2, _mm_load_pd,    _mm_store_pd,     _mm_set1_pd,    _mm_add_pd,    _mm_mul_pd)
+UB_STREAM_KERNELS(sse2_nt,   "sse2",    __m128d, 2, _mm_load_pd,    _mm_stream_pd,    _mm_set1_pd,    _mm_add_pd,    _mm_mul_pd)
+UB_STREAM_KERNELS(avx2,      "avx2",    __m256d, 4, _mm256_load_pd, _mm256_store_pd,  _mm256_set1_pd, _mm256_add_pd, _mm256_mul_pd)
+UB_STREAM_KERNELS(avx2_nt,   "avx2",    __m256d, 4, _mm256_load_pd, _mm256_stream_pd, _mm256_set1_pd, _mm256_add_pd, _mm256_mul_pd)
+UB_STREAM_KERNELS(avx512,    "avx512f", __m512d, 8, _mm512_load_pd, _mm512_store_pd,  _mm512_set1_pd, _mm512_add_pd, _mm512_mul_pd)
+UB_STREAM_KERNELS(avx512_nt, "avx512f", __m512d, 8, _mm512_load_pd, _mm512_stream_pd, _mm512_set1_pd, _mm512_add_pd, _mm512_mul_pd)
+#endif
+
+static bool always() { return true; }
+#ifdef UB_X86
+static bool has_sse2() { return __builtin_cpu_supports("sse2"); }
+static bool has_avx2() { return __builtin_cpu_supports("avx2"); }
+static bool has_avx512() { return __builtin_cpu_supports("avx512f"); }
+#endif
+
+struct Isa {
+    const char* name;
+    bool (*supported)();
+    StreamFn fn[4];         // copy, scale, add, triad
+    bool nt;                // streaming stores, needs an sfence after each pass
+};
+
+static const Isa isas[] = {
+    {"scalar",    always,     {copy_scalar, scale_scalar, add_scalar, triad_scalar}, false},
+#ifdef UB_X86
+    {"sse2",      has_sse2,   {copy_sse2, scale_sse2, add_sse2, triad_sse2}, false},
+    {"sse2-nt",   has_sse2,   {copy_sse2_nt, scale_sse2_nt, add_sse2_nt, triad_sse2_nt}, true},
+    {"avx2",      has_avx2,   {copy_avx2, scale_avx2, add_avx2, triad_avx2}, false},
+    {"avx2-nt",   has_avx2,   {copy_avx2_nt, scale_avx2_nt, add_avx2_nt, triad_avx2_nt}, true},
+    {"avx512",    has_avx512, {copy_avx512, scale_avx512, add_avx512, triad_avx512}, false},
+    {"avx512-nt", has_avx512, {copy_avx512_nt, scale_avx512_nt, add_avx512_nt, triad_avx512_nt}, true},
+#endif
+};
+
+static const char* const kernel_names[4] = {"copy", "scale", "add", "triad"};
+static const int arrays_touched[4] = {2, 2, 3, 3};    // STREAM byte accounting
+
+// ----------------------------------------------------------- threading ----
+struct Job {
+    StreamFn fn = nullptr;
+    size_t n = 0;
+    bool nt = false;
+};
+
+struct alignas(64) Slot {
+    Arrays v = {nullptr, nullptr, nullptr};
+    unsigned long passes = 0;
+    uint64_t end_ns = 0;
+};
+
+static Job job;
+
+constexpr double PROBE_SECONDS = 0.1;  // per instruction set when -S picks one
+static std::atomic<bool> stop{false};
+
+// Allocate and first-touch on the worker's own CPU (local NUMA node)
+static void worker_init(Slot* slot, size_t max_n) {
+    double** arrays[3] = {&slot->v.a, &slot->v.b, &slot->v.c};
+    for (double** p : arrays) {
+        *p = static_cast<double*>(aligned_alloc(4096, (max_n * sizeof(double) + 4095) & ~size_t(4095)));
+        if (*p == nullptr) {
+            cerr << "membw: out of memory" << endl;
+            exit(1);
+        }
+    }
+    for (size_t i = 0; i < max_n; ++i) {
+        slot->v.a[i] = 1.0;
+        slot->v.b[i] = 2.0;
+        slot->v.c[i] = 0.0;
+    }
+}
+
+// One point: run the job's kernel until the window closes
+static void worker_run(Slot* slot) {
+    const Job j = job;
+    unsigned long passes = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+        j.fn(slot->v, j.n, 3.0);
+#ifdef UB_X86
+        if (j.nt)
+            _mm_sfence();
+#endif
+        ++passes;
+    }
+    slot->passes = passes;
+    slot->end_ns = now_ns();
+}
+
+static void worker_fini(Slot* slot) {
+    free(slot->v.a);
+    free(slot->v.b);
+    free(slot->v.c);
+}
+
+struct PointResult {
+    double mbps = 0;
+    unsigned long passes = 0;
+    uint64_t elapsed = 0;
+};
+
+// Run kernel k of isa over n elements per thread on every worker for one window
+static PointResult measure(WorkerPool& pool, const vector<Slot>& slots, int k, const Isa* isa, size_t n,
+                           double seconds, bool gated) {
+    job.fn = isa->fn[k];
+    job.n = n;
+    job.nt = isa->nt;
+    stop.store(false, std::memory_order_relaxed);
+
+    uint64_t t0, t1;
+    if (!(gated && start_gate(seconds, t0, t1))) {
+        t0 = now_ns();
+        t1 = t0 + static_cast<uint64_t>(seconds * 1e9);
+    }
+    pool.release(pool.size());
+    sleep_until(t1);
+    stop.store(true, std::memory_order_relaxed);
+    pool.wait();
+
+    double bytes_per_pass = static_cast<double>(arrays_touched[k]) * static_cast<double>(n) * sizeof(double);
+    PointResult pt;
+    for (const auto& s : slots) {
+        uint64_t ns = s.end_ns - t0;
+        pt.mbps += bytes_per_pass * static_cast<double>(s.passes) / (static_cast<double>(ns) / 1e9) / 1e6;
+        pt.passes += s.passes;
+        pt.elapsed = max(pt.elapsed, ns);
+    }
+    return pt;
+}
+
+static void usage(const char* prog) {
+    cerr << "Usage: " << prog << " [-t threads] [-n | -p policy] [-k kernels] [-i isas] [-m max_kib] [-S] duration" << endl;
+    cerr << "  -t threads  number of pinned worker threads (default 1)" << endl;
+    cerr << "  -n          do not pin workers to CPUs" << endl;
+    cerr << "  -p policy   placement: compact, scatter, core or node (default: ascending CPU number)" << endl;
+    cerr << "  -k kernels  comma separated subset of copy,scale,add,triad (default all)" << endl;
+    cerr << "  -i isas     comma separated subset of the supported instruction sets (default all):";
+    for (const auto& isa : isas) {
+        if (isa.supported())
+            cerr << " " << isa.name;
+    }
+    cerr << endl;
+    cerr << "  -m max_kib  largest per-thread working set (default 4 x LLC / threads)" << endl;
+    cerr << "  -S          measure only the scored point (largest size), for the whole duration" << endl;
+    cerr << "duration is the total time in seconds, shared by all sweep points" << endl;
+    exit(1);
+}
+
+int main(int argc, char* argv[]) {
+    int threads = 1;
+    bool pin = true;
+    string policy;
+    string kernel_list, isa_list;
+    size_t max_kib = 0;
+    bool score_only = false;
+
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; ++arg) {
+        if (strcmp(argv[arg], "-t") == 0 && arg + 1 < argc) {
+            threads = atoi(argv[++arg]);
+        } else if (strcmp(argv[arg], "-n") == 0) {
+            pin = false;
+        } else if (strcmp(argv[arg], "-p") == 0 && arg + 1 < argc) {
+            policy = argv[++arg];
+        } else if (strcmp(argv[arg], "-k") == 0 && arg + 1 < argc) {
+            kernel_list = argv[++arg];
+        } else if (strcmp(argv[arg], "-i") == 0 && arg + 1 < argc) {
+            isa_list = argv[++arg];
+        } else if (strcmp(argv[arg], "-m") == 0 && arg + 1 < argc) {
+            max_kib = strtoul(argv[++arg], nullptr, 10);
+        } else if (strcmp(argv[arg], "-S") == 0) {
+            score_only = true;
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (arg >= argc || threads < 1)
+        usage(argv[0]);
+    double duration = parse_duration(argv[arg]);
+    if (duration <= 0) {
+        cerr << "Invalid duration: " << argv[arg] << endl;
+        exit(1);
+    }
+
+    // Working-set sweep (all three arrays of one thread): 16 KiB doubling up to
+    // 4 x LLC shared between the threads, so the last point is DRAM bound
+    size_t llc = llc_size();
+    size_t max_ws = max_kib ? max_kib << 10 : max<size_t>(4 * llc / threads, 8u << 20);
+    vector<size_t> sizes;
+    for (size_t ws = 16u << 10; ws < max_ws; ws *= 2)
+        sizes.push_back(ws);
+    sizes.push_back(max_ws);
+
+    // Elements per array, a multiple of 64 so every SIMD width divides it
+    auto elements = [](size_t ws) { return max<size_t>(64, (ws / 3 / sizeof(double)) & ~size_t(63)); };
+    size_t max_n = elements(max_ws);
+
+    vector<const Isa*> run_isas;
+    for (const auto& isa : isas) {
+        if (isa.supported() && in_list(isa_list, isa.name))
+            run_isas.push_back(&isa);
+    }
+    vector<int> run_kernels;
+    for (int k = 0; k < 4; ++k) {
+        if (in_list(kernel_list, kernel_names[k]))
+            run_kernels.push_back(k);
+    }
+    if (run_isas.empty() || run_kernels.empty())
+        usage(argv[0]);
+
+    // Index score: triad at the largest working set (first selected kernel if triad was skipped)
+    int score_k = in_list(kernel_list, "triad") ? 3 : run_kernels.front();
+
+    vector<int> cpus = policy.empty() ? allowed_cpus() : place_cpus(policy, threads);
+    if (cpus.empty() && !policy.empty()) {
+        cerr << "Unknown placement policy: " << policy << endl;
+        usage(argv[0]);
+    }
+    vector<Slot> slots(threads);
+    vector<int> worker_cpus;
+    for (int i = 0; i < threads; ++i)
+        worker_cpus.push_back((pin && !cpus.empty()) ? cpus[i % cpus.size()] : -1);
+    WorkerPool pool;
+    pool.start(worker_cpus, [&](int tid) { worker_run(&slots[tid]); },
+               [&](int tid) { worker_init(&slots[tid], max_n); }, [&](int tid) { worker_fini(&slots[tid]); });
+
+    if (score_only) {
+        // Per-copy setup before the gate: a short window per instruction set picks the
+        // fastest, then the scored point is the only point of the run
+        const Isa* best = run_isas.front();
+        double best_mbps = -1;
+        for (const Isa* isa : run_isas) {
+            double mbps = run_isas.size() > 1 ? measure(pool, slots, score_k, isa, max_n, PROBE_SECONDS, false).mbps : 0;
+            if (mbps > best_mbps) {
+                best_mbps = mbps;
+                best = isa;
+            }
+        }
+        run_isas.assign(1, best);
+        run_kernels.assign(1, score_k);
+        sizes.assign(1, max_ws);
+    }
+    size_t points = sizes.size() * run_isas.size() * run_kernels.size();
+    double slice = max(duration / static_cast<double>(points), 0.02);
+
+    printf("membw: %d thread(s), LLC %zu KiB, %zu points of %.3f s\n", threads, llc >> 10, points, slice);
+    printf("%-6s %-10s %12s %14s\n", "kernel", "isa", "ws (KiB)", "MB/s");
+
+    // Best result per kernel at the largest size, for the index and the summary
+    double dram_best[4] = {0, 0, 0, 0};
+    const char* dram_isa[4] = {"", "", "", ""};
+    uint64_t dram_ns[4] = {0, 0, 0, 0};
+    unsigned long dram_passes[4] = {0, 0, 0, 0};
+    bool first = true;
+
+    for (size_t ws : sizes) {
+        size_t n = elements(ws);
+        for (int k : run_kernels) {
+            for (const Isa* isa : run_isas) {
+                // The first point waits at the cross-copy start gate
+                PointResult pt = measure(pool, slots, k, isa, n, slice, first);
+                first = false;
+                double mbps = pt.mbps;
+                unsigned long passes = pt.passes;
+                uint64_t elapsed = pt.elapsed;
+                printf("%-6s %-10s %12zu %14.1f\n", kernel_names[k], isa->name, ws >> 10, mbps);
+
+                BenchResult r("membw", passes, elapsed, "MBps");
+                r.count = mbps;
+                r.tag("kernel", kernel_names[k]);
+                r.tag("isa", isa->name);
+                r.add("ws_bytes", static_cast<double>(ws), "point");
+                r.add("threads", threads, "point");
+                emit_json(r);
+
+                if (ws == max_ws && mbps > dram_best[k]) {
+                    dram_best[k] = mbps;
+                    dram_isa[k] = isa->name;
+                    dram_ns[k] = elapsed;
+                    dram_passes[k] = passes;
+                }
+            }
+        }
+    }
+
+    pool.stop();
+    fflush(stdout);
+
+    BenchResult result("membw", dram_passes[score_k], dram_ns[score_k], "MBps");
+    result.count = dram_best[score_k];
+    result.tag("kernel", kernel_names[score_k]);
+    result.tag("isa", dram_isa[score_k]);
+    result.add("threads", threads, "config");
+    if (pin && !policy.empty())
+        result.tag("placement", policy);
+    result.add("ws_bytes", static_cast<double>(max_ws), "config");
+    result.add("llc_bytes", static_cast<double>(llc), "config");
+    for (int k : run_kernels)
+        result.add(string(kernel_names[k]) + "_mbps", dram_best[k], "dram");
+    emit_result(result);
+    return 0;
+}
@@ -0,0 +1,40 @@
+/**
+ * @file        memchase.cpp
+ * @brief       Dependent pointer chase over a random ring of cache lines
+ * @author      rRNA
+ * @version     4.0.0
+ * @date        10-17-2026
+ */
+
+#include "memchase.hpp"
+
+#include <utility>
+#include <vector>
+
+void* build_ring(char* base, size_t bytes, std::mt19937_64& rng) {
+    size_t lines = bytes / RING_LINE;
+    std::vector<size_t> order(lines);
+    for (size_t i = 0; i < lines; ++i)
+        order[i] = i;
+    // Sattolo's algorithm: a uniformly random single cycle
+    for (size_t i = lines - 1; i > 0; --i) {
+        size_t j = std::uniform_int_distribution<size_t>(0, i - 1)(rng);
+        std::swap(order[i], order[j]);
+    }
+    for (size_t i = 0; i < lines; ++i) {
+        size_t next = (i + 1 < lines) ? order[i + 1] : order[0];
+        *reinterpret_cast<void**>(base + order[i] * RING_LINE) = base + next * RING_LINE;
+    }
+    return base + order[0] * RING_LINE;
+}
+
+#define UB_STEP p = *static_cast<void**>(p);
+#define UB_STEP16 UB_STEP UB_STEP UB_STEP UB_STEP UB_STEP UB_STEP UB_STEP UB_STEP \
+                  UB_STEP UB_STEP UB_STEP UB_STEP UB_STEP UB_STEP UB_STEP UB_STEP
+
+void* chase(void* p, unsigned long loads) {
+    for (unsigned long i = 0; i < loads; i += 16) {
+        UB_STEP16
+    }
+    return p;
+}
@@ -0,0 +1,32 @@
+/**
+ * @file        memchase.hpp
+ * @brief       Dependent pointer chase over a random ring of cache lines
+ * @author      rRNA
+ * @version     4.0.0
+ * @date        10-17-2026
+ *
+ * @details
+ * Shared by memlat (latency per buffer size) and numamat (latency per node
+ * pair). Every load depends on the previous one and the ring is a single
+ * random cycle, so neither the prefetchers nor memory-level parallelism can
+ * hide the latency of a load.
+ *
+ *     void* p = build_ring(buf, bytes, rng);
+ *     p = chase(p, loads);
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <random>
+
+// Ring element stride, one cache line
+constexpr size_t RING_LINE = 64;
+
+// Link the first `bytes` of base into one random cycle over its cache lines and
+// return the starting element
+void* build_ring(char* base, size_t bytes, std::mt19937_64& rng);
+
+// Follow the ring for `loads` loads (rounded up to a multiple of 16) and return
+// where it stopped, so the caller can sink the result and continue from there
+void* chase(void* p, unsigned long loads);
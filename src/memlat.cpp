@@ -0,0 +1,217 @@
+/**
+ * @file        memlat.cpp
+ * @brief       Cache and memory latency ladder (dependent pointer chasing)
+ * @author      rRNA
+ * @version     4.0.0
+ * @date        10-17-2026
+ *
+ * @details
+ * Every cache line of a buffer holds a pointer to the next line of a single
+ * random cycle (Sattolo's algorithm), so each load depends on the previous one
+ * and neither the prefetchers nor out-of-order execution can hide the latency.
+ * The chase is repeated for buffer sizes from 4 KiB to 1 GiB, once with normal
+ * 4 KiB pages (THP disabled) and once with huge pages (hugetlbfs if pages are
+ * reserved, transparent huge pages otherwise). Steps in ns/load mark the L1,
+ * L2, L3 and DRAM boundaries; the gap between the two page modes shows the
+ * TLB reach.
+ *
+ * Each size is reported as a JSON line. The final COUNT| result is loads per
+ * second at the largest size (DRAM), so that, like every other index test,
+ * higher is better; the whole ladder is attached in ns.
+ *
+ * Usage:
+ *   memlat [-p normal|huge|both] [-m max_kib] duration
+ */
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <sys/mman.h>
+
+#include "timeit.hpp"
+#include "result.hpp"
+#include "memchase.hpp"
+
+using namespace std;
+
+constexpr size_t HUGE_PAGE = 2u << 20;
+constexpr unsigned long CHUNK = 1024;   // loads between two checks of the stop flag
+
+struct Buffer {
+    char* base = nullptr;
+    size_t bytes = 0;
+    void* map = nullptr;
+    size_t map_bytes = 0;
+    const char* source = "";
+};
+
+static Buffer map_buffer(size_t bytes, bool huge) {
+    Buffer b;
+    b.bytes = bytes;
+    if (huge) {
+        // Reserved hugetlbfs pages first, they are guaranteed to be 2 MiB
+        size_t len = (bytes + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1);
+        void* p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            b.map = p;
+            b.map_bytes = len;
+            b.base = static_cast<char*>(p);
+            b.source = "hugetlbfs";
+            return b;
+        }
+        // Otherwise a 2 MiB aligned region with transparent huge pages requested
+        len += HUGE_PAGE;
+        p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED)
+            return b;
+        b.map = p;
+        b.map_bytes = len;
+        uintptr_t aligned = (reinterpret_cast<uintptr_t>(p) + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1);
+        b.base = reinterpret_cast<char*>(aligned);
+        b.source = (madvise(b.base, len - HUGE_PAGE, MADV_HUGEPAGE) == 0) ? "thp" : "none";
+        return b;
+    }
+    void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+        return b;
+    b.map = p;
+    b.map_bytes = bytes;
+    b.base = static_cast<char*>(p);
+#ifdef MADV_NOHUGEPAGE
+    madvise(p, bytes, MADV_NOHUGEPAGE);
+#endif
+    b.source = "4k";
+    return b;
+}
+
+static void unmap_buffer(Buffer& b) {
+    if (b.map)
+        munmap(b.map, b.map_bytes);
+    b = Buffer();
+}
+
+static void* volatile sink;
+
+static void usage(const char* prog) {
+    cerr << "Usage: " << prog << " [-p normal|huge|both] [-m max_kib] duration" << endl;
+    cerr << "  -p pages    page size mode(s) to measure (default both)" << endl;
+    cerr << "  -m max_kib  largest buffer in KiB (default 1048576 = 1 GiB)" << endl;
+    cerr << "duration is the total time in seconds, shared by all sizes" << endl;
+    exit(1);
+}
+
+static string size_label(size_t bytes) {
+    char buf[32];
+    if (bytes >= (1u << 30))
+        snprintf(buf, sizeof(buf), "%zuG", bytes >> 30);
+    else if (bytes >= (1u << 20))
+        snprintf(buf, sizeof(buf), "%zuM", bytes >> 20);
+    else
+        snprintf(buf, sizeof(buf), "%zuK", bytes >> 10);
+    return buf;
+}
+
+int main(int argc, char* argv[]) {
+    string pages = "both";
+    size_t max_bytes = 1u << 30;
+
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; ++arg) {
+        if (strcmp(argv[arg], "-p") == 0 && arg + 1 < argc) {
+            pages = argv[++arg];
+        } else if (strcmp(argv[arg], "-m") == 0 && arg + 1 < argc) {
+            max_bytes = static_cast<size_t>(strtoull(argv[++arg], nullptr, 10)) << 10;
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (arg >= argc || (pages != "normal" && pages != "huge" && pages != "both") || max_bytes < (4u << 10))
+        usage(argv[0]);
+    double duration = parse_duration(argv[arg]);
+    if (duration <= 0) {
+        cerr << "Invalid duration: " << argv[arg] << endl;
+        exit(1);
+    }
+
+    vector<size_t> sizes;
+    for (size_t s = 4u << 10; s <= max_bytes; s *= 2)
+        sizes.push_back(s);
+    vector<bool> modes;
+    if (pages != "huge")
+        modes.push_back(false);
+    if (pages != "normal")
+        modes.push_back(true);
+    double slice = max(duration / static_cast<double>(sizes.size() * modes.size()), 0.02);
+
+    printf("memlat: %zu sizes x %zu page mode(s), %.3f s each\n", sizes.size(), modes.size(), slice);
+    printf("%-6s %-10s %10s %10s\n", "pages", "source", "size", "ns/load");
+
+    mt19937_64 rng(0x5eed);
+    BenchResult result;
+    result.name = "memlat";
+    result.unit = "lps";
+    double score_ns = 0;
+    uint64_t score_elapsed = 0;
+    unsigned long score_loads = 0;
+    string score_pages;
+
+    for (bool huge : modes) {
+        Buffer buf = map_buffer(sizes.back(), huge);
+        if (buf.base == nullptr) {
+            cerr << "memlat: cannot map " << size_label(sizes.back()) << " buffer" << endl;
+            exit(1);
+        }
+        const char* mode = huge ? "huge" : "normal";
+        result.tag(string(mode) + "_source", buf.source);
+
+        for (size_t bytes : sizes) {
+            void* p = build_ring(buf.base, bytes, rng);
+            // One lap to pull the ring into whatever level it fits in (no point beyond 64 MiB)
+            p = chase(p, min<unsigned long>(max<unsigned long>(CHUNK, bytes / RING_LINE), 1ul << 20));
+
+            BenchTimer timer;
+            timer.start(slice);
+            unsigned long loads = 0;
+            while (!timer.expired()) {
+                p = chase(p, CHUNK);
+                loads += CHUNK;
+            }
+            uint64_t ns = timer.stop();
+            sink = p;
+
+            double ns_per_load = static_cast<double>(ns) / static_cast<double>(loads);
+            printf("%-6s %-10s %10s %10.2f\n", mode, buf.source, size_label(bytes).c_str(), ns_per_load);
+
+            BenchResult r("memlat", loads, ns, "ns");
+            r.count = ns_per_load;
+            r.tag("pages", mode);
+            r.tag("source", buf.source);
+            r.add("size_bytes", static_cast<double>(bytes), "point");
+            emit_json(r);
+
+            result.add(string(mode) + "_" + size_label(bytes) + "_ns", ns_per_load, "ladder");
+            // Score: the largest size, preferring huge pages (no TLB component) when measured
+            if (bytes == sizes.back() && (score_pages.empty() || huge)) {
+                score_ns = ns_per_load;
+                score_elapsed = ns;
+                score_loads = loads;
+                score_pages = mode;
+            }
+        }
+        unmap_buffer(buf);
+    }
+    fflush(stdout);
+
+    result.count = score_ns > 0 ? 1e9 / score_ns : 0;
+    result.elapsed_ns = score_elapsed;
+    result.iterations = score_loads;
+    result.tag("pages", score_pages);
+    result.add("dram_ns", score_ns, "config");
+    result.add("max_bytes", static_cast<double>(sizes.back()), "config");
+    emit_result(result);
+    return 0;
+}
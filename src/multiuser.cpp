@@ -0,0 +1,437 @@
+/**
+ * @file        multiuser.cpp
+ * @brief       Multi-user interactive workload simulator built on the big.cpp job driver
+ * @author      rRNA
+ * @version     4.0.0
+ * @date        10-17-2026
+ *
+ * @details
+ * big.c was the "makework" driver of the original multi-user test: it read job
+ * streams from a script, forked one command per simulated user and typed each
+ * job's standard input into it at a limited rate. big.cpp kept its structures
+ * (Work, Child, getWork(), the typing threshold); this is the main loop.
+ *
+ * Every line of the job script is
+ *
+ *     command [args ...] [< input_file]
+ *
+ * Lines starting with # are comments, relative input files are looked up next
+ * to the script and commands are found on PATH. User i starts with job
+ * i mod jobs and then works through the script in turn: the command is forked
+ * with a pipe on its standard input and its output discarded (or written to
+ * the file named by a "C=" line of its input), the input is typed in bursts of
+ * 1..CHUNK characters, whole lines at a time, and when the command exits the
+ * user starts the next job. As in the original, typing shares one budget:
+ * every GRANULE seconds the threshold grows by users * rate * GRANULE
+ * characters, and the driver sleeps while it is ahead of it.
+ *
+ * The original master blocked in write() on each child's pipe and paced
+ * itself with alarm()/pause(), so one slow reader stalled every user and it
+ * had to fork clone masters of MAXCHILD users each. Here a single epoll loop
+ * drives all users: the pipes are written nonblocking (a full pipe parks that
+ * user until EPOLLOUT), job exits arrive as pidfd readiness and are reaped
+ * with waitid(P_PIDFD), and SIGPIPE is ignored in favour of EPIPE. No signal
+ * handler runs except BenchTimer's, so thousands of users cost two
+ * descriptors each and nothing else; RLIMIT_NOFILE is raised to match.
+ *
+ *   -u users   simulated users (default 8, up to MAX_USERS)
+ *   -r rate    characters per second typed by each user (default DEF_RATE,
+ *              the original 5); 0 types as fast as the pipes take it
+ *   -j script  job script (default: standard input)
+ *
+ * COUNT| is jobs completed per minute. Jobs still running when the window
+ * closes are killed and not counted. Per-job latency (fork to exit) goes out
+ * as the "latency" group, completions of each script line as "per_job".
+ *
+ * Usage:
+ *   multiuser [-u users] [-r rate] [-j script] duration
+ */
+
+#include <iostream>
+#include <fstream>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "big.hpp"
+#include "timeit.hpp"
+#include "result.hpp"
+#include "histogram.hpp"
+#include "topology.hpp"
+
+using namespace std;
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+
+constexpr uint64_t GRANULE_NS = static_cast<uint64_t>(GRANULE) * 1000000000ULL;
+constexpr int MAX_USERS = 1 << 16;
+constexpr int RESERVED_FDS = 32;    // stdio, the epoll instance, the job script, ...
+constexpr int MAX_EVENTS = 256;
+
+// epoll_event.data: user index, shifted, plus which of its descriptors is ready
+constexpr uint64_t EV_PIDFD = 0;
+constexpr uint64_t EV_PIPE = 1;
+
+struct Totals {
+    uint64_t jobs = 0;          // jobs that exited inside the window
+    uint64_t failed = 0;        // of those, non-zero exit status or killed by a signal
+    uint64_t chars = 0;         // characters typed
+    vector<uint64_t> per_job;   // completions of each script line
+    LatencyHistogram latency;   // fork to exit, nanoseconds
+};
+
+static int epfd = -1;
+
+static void usage(const char* prog) {
+    cerr << "Usage: " << prog << " [-u users] [-r rate] [-j script] duration" << endl;
+    cerr << "  script lines: command [args ...] [< input_file]" << endl;
+    exit(1);
+}
+
+static string base_name(const string& path) {
+    size_t slash = path.rfind('/');
+    return slash == string::npos ? path : path.substr(slash + 1);
+}
+
+static void watch(int fd, uint32_t events, size_t user, uint64_t kind) {
+    struct epoll_event ev = {};
+    ev.events = events;
+    ev.data.u64 = (static_cast<uint64_t>(user) << 1) | kind;
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+        exitStatus = 4;
+        wrapUp(string("** epoll_ctl failed: ") + strerror(errno) + " **");
+    }
+}
+
+// Fork the user's current job with a pipe on its standard input
+static void start_job(Child& c, size_t user) {
+    const Work& w = works[c.currentJob];
+    int pv[2];
+    // Close-on-exec, so no job holds another user's pipe open and every job sees EOF
+    if (pipe2(pv, O_CLOEXEC) == -1) {
+        exitStatus = 4;
+        wrapUp("** pipe failed **");
+    }
+
+    vector<char*> av;
+    av.push_back(const_cast<char*>(w.cmd.c_str()));
+    for (const string& a : w.args)
+        av.push_back(const_cast<char*>(a.c_str()));
+    av.push_back(nullptr);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(pv[0], 0);
+        // stderr is our result channel, so the jobs' diagnostics are dropped
+        const char* out = w.outputFile.empty() ? "/dev/null" : w.outputFile.c_str();
+        int fd = open(out, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0)
+            dup2(fd, 1);
+        fd = open("/dev/null", O_WRONLY);
+        if (fd >= 0)
+            dup2(fd, 2);
+        signal(SIGPIPE, SIG_DFL);   // an ignored signal would stay ignored across exec
+        execvp(av[0], av.data());
+        _exit(127);
+    }
+    if (pid == -1) {
+        exitStatus = 4;
+        wrapUp("** fork failed **");
+    }
+    close(pv[0]);
+    // The job is not reaped until its pidfd fires, so the pid cannot be reused before this
+    c.pidfd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+    if (c.pidfd == -1) {
+        kill(pid, SIGKILL);
+        exitStatus = 4;
+        wrapUp(string("** pidfd_open failed: ") + strerror(errno) + " **");
+    }
+    c.pid = pid;
+    c.fd = pv[1];
+    c.inputBuffer = w.input;
+    c.inputPos = 0;
+    c.lineEnd = 0;
+    c.xmit = 0;
+    c.started = now_ns();
+    watch(c.pidfd, EPOLLIN, user, EV_PIDFD);
+    if (c.inputBuffer.empty()) {
+        close(c.fd);
+        c.fd = -1;
+        return;
+    }
+    fcntl(c.fd, F_SETFL, O_NONBLOCK);   // the job's end stays blocking
+    // Edge-triggered: one event each time a full pipe drains
+    watch(c.fd, EPOLLOUT | EPOLLET, user, EV_PIPE);
+}
+
+// Stop typing into a job (end of input, or it exited first)
+static void end_input(Child& c) {
+    epoll_ctl(epfd, EPOLL_CTL_DEL, c.fd, nullptr);
+    close(c.fd);
+    c.fd = -1;
+}
+
+// A user can type when its input is not used up and nothing typed is still waiting for the pipe
+static bool can_type(const Child& c) {
+    return c.fd >= 0 && c.inputPos == c.lineEnd;
+}
+
+// Write the typed lines the pipe takes without blocking; the rest waits for EPOLLOUT
+static void flush(Child& c) {
+    int len = static_cast<int>(c.inputBuffer.size());
+    while (c.inputPos < c.lineEnd) {
+        ssize_t w = write(c.fd, c.inputBuffer.data() + c.inputPos, static_cast<size_t>(c.lineEnd - c.inputPos));
+        if (w < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN)
+                return;
+            if (errno != EPIPE) {
+                exitStatus = 4;
+                wrapUp("** write error **");
+            }
+            // The job exited without reading all of its input
+            ++sigpipe;
+            c.xmit = c.inputPos = c.lineEnd = len;
+            break;
+        }
+        c.inputPos += static_cast<int>(w);
+    }
+    if (c.inputPos >= len)
+        end_input(c);
+}
+
+// Type the next burst of 1..CHUNK characters. Lines go to the pipe as they are
+// completed, the unterminated tail of the input with the last burst.
+static int type_burst(Child& c) {
+    int len = static_cast<int>(c.inputBuffer.size());
+    int l = rand() % CHUNK + 1;
+    if (c.xmit + l > len)
+        l = len - c.xmit;
+    const char* buf = c.inputBuffer.data();
+    for (int i = c.xmit; i < c.xmit + l; ++i) {
+        if (buf[i] == '\n')
+            c.lineEnd = i + 1;
+    }
+    c.xmit += l;
+    if (c.xmit >= len)
+        c.lineEnd = len;
+    flush(c);
+    return l;
+}
+
+// Collect an exited job; while the window is open the user goes on with its next job
+static void reap(Totals& t, const BenchTimer& timer, size_t user) {
+    Child& c = children[user];
+    siginfo_t info = {};
+    while (waitid(P_PIDFD, static_cast<id_t>(c.pidfd), &info, WEXITED | WNOHANG) < 0) {
+        if (errno != EINTR) {
+            exitStatus = 4;
+            wrapUp(string("** waitid failed: ") + strerror(errno) + " **");
+        }
+    }
+    if (info.si_pid == 0)
+        return;     // not this job: an event queued for the user's previous one
+    uint64_t now = now_ns();
+    // Removed explicitly: a job forked but not yet exec'd still holds a copy of the
+    // pidfd, which would keep it in the epoll set after close()
+    epoll_ctl(epfd, EPOLL_CTL_DEL, c.pidfd, nullptr);
+    close(c.pidfd);
+    c.pidfd = -1;
+    c.pid = 0;
+    if (c.fd >= 0)
+        end_input(c);
+    if (info.si_code == CLD_EXITED && info.si_status == 127) {
+        exitStatus = 4;
+        wrapUp("cannot exec " + works[c.currentJob].cmd);
+    }
+    ++t.jobs;
+    ++t.per_job[c.currentJob];
+    if (info.si_code != CLD_EXITED || info.si_status != 0)
+        ++t.failed;
+    t.latency.record(now - c.started);
+    c.currentJob = (c.currentJob + 1) % static_cast<int>(works.size());
+    if (!timer.expired())
+        start_job(c, user);
+}
+
+int main(int argc, char* argv[]) {
+    int users = 8;
+    float rate = DEF_RATE;
+    string script;
+
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; ++arg) {
+        if (strcmp(argv[arg], "-u") == 0 && arg + 1 < argc)
+            users = atoi(argv[++arg]);
+        else if (strcmp(argv[arg], "-r") == 0 && arg + 1 < argc)
+            rate = strtof(argv[++arg], nullptr);
+        else if (strcmp(argv[arg], "-j") == 0 && arg + 1 < argc)
+            script = argv[++arg];
+        else
+            usage(argv[0]);
+    }
+    if (arg + 1 != argc || users < 1 || users > MAX_USERS || rate < 0)
+        usage(argv[0]);
+    double duration = parse_duration(argv[arg]);
+    if (duration <= 0) {
+        cerr << "Invalid duration: " << argv[arg] << endl;
+        exit(1);
+    }
+
+    if (script.empty()) {
+        getWork();
+    } else {
+        ifstream in(script);
+        if (!in)
+            fatal("cannot open job script " + script);
+        size_t slash = script.rfind('/');
+        getWork(in, slash == string::npos ? "." : script.substr(0, slash));
+    }
+    if (works.empty())
+        fatal("no jobs in the script");
+
+    // A pipe and a pidfd per user
+    rlim_t need = 2 * static_cast<rlim_t>(users) + RESERVED_FDS;
+    rlim_t limit = raise_nofile(need);
+    if (limit < need)
+        fatal("RLIMIT_NOFILE " + to_string(limit) + " is too low for " + to_string(users) + " users");
+
+    numUsers = users;
+    firstUser = 0;
+    children.assign(users, Child());
+    Totals totals;
+    totals.per_job.assign(works.size(), 0);
+
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd == -1)
+        fatal("** epoll_create1 failed **");
+    signal(SIGPIPE, SIG_IGN);   // a job that stops reading shows up as EPIPE
+    srand(static_cast<unsigned>(time(nullptr)) ^ static_cast<unsigned>(getpid()));
+
+    printf("multiuser: %d users, %zu jobs, ", users, works.size());
+    if (rate > 0)
+        printf("%.1f chars/s per user\n", rate);
+    else
+        printf("unthrottled typing\n");
+
+    BenchTimer timer;
+    timer.start(duration);
+    // The original starting budget: one GRANULE for every user with input
+    threshold = 0;
+    estimatedRate = static_cast<float>(users) * rate * GRANULE;
+    uint64_t next_tick = timer.start_ns() + GRANULE_NS;
+    for (int i = 0; i < users; ++i) {
+        Child& c = children[i];
+        c.firstJob = c.currentJob = i % static_cast<int>(works.size());
+        start_job(c, static_cast<size_t>(i));
+        if (c.fd >= 0)
+            threshold += rate * GRANULE;
+    }
+
+    vector<struct epoll_event> events(MAX_EVENTS);
+    size_t next_user = 0;   // typing resumes here, so a short budget is shared round robin
+    while (!timer.expired()) {
+        uint64_t now = now_ns();
+        while (now >= next_tick) {
+            onAlarm(0);
+            next_tick += GRANULE_NS;
+        }
+
+        // One burst for every user that can type, until the budget runs out
+        bool typed = false;
+        for (size_t k = 0; k < children.size(); ++k) {
+            if (rate > 0 && static_cast<float>(totals.chars) > threshold)
+                break;
+            size_t i = (next_user + k) % children.size();
+            if (!can_type(children[i]))
+                continue;
+            totals.chars += static_cast<uint64_t>(type_burst(children[i]));
+            typed = true;
+            next_user = i + 1;
+        }
+
+        // Poll when there may be more to type, otherwise sleep until a pipe drains,
+        // a job exits, the next granule, or the end of the window (SIGALRM interrupts this)
+        bool budget = rate == 0 || static_cast<float>(totals.chars) <= threshold;
+        int timeout = 0;
+        if (!(typed && budget)) {
+            uint64_t wait = next_tick > now ? next_tick - now : 0;
+            timeout = static_cast<int>((wait + 999999) / 1000000);
+        }
+        int n = epoll_wait(epfd, events.data(), MAX_EVENTS, timeout);
+        for (int e = 0; e < n; ++e) {
+            size_t user = static_cast<size_t>(events[e].data.u64 >> 1);
+            Child& c = children[user];
+            if ((events[e].data.u64 & 1) == EV_PIPE) {
+                if (c.fd >= 0)
+                    flush(c);
+            } else if (c.pidfd >= 0) {
+                reap(totals, timer, user);
+            }
+        }
+    }
+    uint64_t ns = timer.stop();
+
+    // Whatever is still running did not finish inside the window
+    uint64_t killed = 0;
+    for (Child& c : children) {
+        if (c.fd >= 0)
+            end_input(c);
+        if (c.pid > 0)
+            kill(c.pid, SIGKILL);
+    }
+    for (Child& c : children) {
+        if (c.pidfd < 0)
+            continue;
+        siginfo_t info;
+        while (waitid(P_PIDFD, static_cast<id_t>(c.pidfd), &info, WEXITED) < 0 && errno == EINTR) {
+        }
+        close(c.pidfd);
+        c.pidfd = -1;
+        c.pid = 0;
+        ++killed;
+    }
+    close(epfd);
+
+    double secs = static_cast<double>(ns) / 1e9;
+    double per_min = static_cast<double>(totals.jobs) * 60.0 / secs;
+    printf("%8s %10s %12s %12s %12s\n", "jobs", "jobs/min", "p50 ms", "p99 ms", "chars/s");
+    printf("%8lu %10.1f %12.2f %12.2f %12.0f\n", static_cast<unsigned long>(totals.jobs), per_min,
+           static_cast<double>(totals.latency.percentile(0.50)) / 1e6,
+           static_cast<double>(totals.latency.percentile(0.99)) / 1e6,
+           static_cast<double>(totals.chars) / secs);
+    for (size_t j = 0; j < works.size(); ++j)
+        printf("  %6lu  %s\n", static_cast<unsigned long>(totals.per_job[j]), works[j].cmd.c_str());
+    fflush(stdout);
+
+    BenchResult result(bench_name(argv[0]), totals.jobs, ns, "jpm", 60);
+    if (!script.empty())
+        result.tag("script", script);
+    result.add("users", users, "config");
+    result.add("rate", rate, "config");
+    result.add("jobs", static_cast<double>(works.size()), "config");
+    result.add("completed", static_cast<double>(totals.jobs), "jobs");
+    result.add("jobs_per_min", per_min, "jobs");
+    result.add("failed", static_cast<double>(totals.failed), "jobs");
+    result.add("killed", static_cast<double>(killed), "jobs");
+    result.add("chars_typed", static_cast<double>(totals.chars), "jobs");
+    result.add("sigpipe", sigpipe, "jobs");
+    for (size_t j = 0; j < works.size(); ++j)
+        result.add(to_string(j) + "_" + base_name(works[j].cmd), static_cast<double>(totals.per_job[j]), "per_job");
+    report_histogram(result, totals.latency, 1.0);
+    emit_result(result);
+    return 0;
+}
@@ -0,0 +1,770 @@
+/**
+ * @file        netbench.cpp
+ * @brief       Loopback TCP/UDP and AF_UNIX socket latency and throughput benchmark
+ * @author      rRNA
+ * @version     4.0.0
+ * @date        10-17-2026
+ *
+ * @details
+ * pipe and context1 measure the kernel's simplest IPC paths; this test drives
+ * the network stack the same way, entirely over 127.0.0.1 and AF_UNIX so the
+ * numbers do not depend on a NIC. Each point runs N client/server thread
+ * pairs, every pair on its own socket, pinned by placement policy:
+ *
+ *   -m rr        request/response: the client sends a message, the server
+ *                echoes it; transactions/s and round-trip latency percentiles
+ *   -m stream    the client streams messages, the server reads them; msgs/s
+ *                and Gbit/s (datagram families also report the delivered share)
+ *   -m connect   connection setup and teardown: connect, accept, the server
+ *                closes first, the client reads EOF and closes (tcp, unix)
+ *   -m mmsg      stream with sendmmsg()/recvmmsg() batches of -B messages
+ *                (udp, unix-dgram)
+ *   -m zerocopy  stream with SO_ZEROCOPY/MSG_ZEROCOPY, completions reaped from
+ *                the error queue (tcp, udp). Loopback delivery has to copy the
+ *                pages anyway; the share the kernel reports as copied is in
+ *                the result
+ *
+ *   -f family    tcp (default), udp, unix (SOCK_STREAM) or unix-dgram
+ *   -s sizes     message sizes, comma separated with K/M suffixes
+ *   -P pairs     largest pair count of the 1, 2, 4 .. sweep (default 1)
+ *   -p policy    placement of the threads: compact, scatter, core or node
+ *
+ * COUNT| is the number of operations (transactions, messages or connections)
+ * and TIME| the window they took, as for every other test. With several points
+ * each one goes out as a JSON line and COUNT|/TIME| belong to the first size at
+ * the most pairs; the rates of all points are under "ops_per_sec".
+ *
+ * Usage:
+ *   netbench [-m mode] [-f family] [-s sizes] [-B batch] [-P pairs] [-p policy] duration
+ */
+
+#include <iostream>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "timeit.hpp"
+#include "result.hpp"
+#include "histogram.hpp"
+#include "perfcount.hpp"
+#include "topology.hpp"
+
+using namespace std;
+
+constexpr size_t MAX_DATAGRAM = 65507;     // largest UDP payload over IPv4
+constexpr int MAX_BATCH = 1024;
+constexpr int DGRAM_TIMEOUT_MS = 20;       // datagram receivers poll the stop flag this often
+constexpr unsigned ZC_OUTSTANDING = 256;   // MSG_ZEROCOPY sends in flight before reaping
+
+struct Config {
+    string mode = "rr";
+    string family = "tcp";
+    int batch = 32;
+};
+
+static bool is_stream(const Config& cfg) {
+    return cfg.family == "tcp" || cfg.family == "unix";
+}
+
+// Per pair counters; the client fills some, the server others
+struct alignas(64) PairStats {
+    unsigned long ops = 0;            // transactions, messages received or connections
+    unsigned long long bytes = 0;     // payload bytes received by the server
+    unsigned long sent = 0;           // messages the client sent
+    unsigned long lost = 0;           // rr over datagrams: requests without a reply
+    unsigned long zc_done = 0;        // MSG_ZEROCOPY sends completed
+    unsigned long zc_copied = 0;      // ... of which the kernel had to copy
+    LatencyHistogram hist;            // rr round trips in ns
+    bool failed = false;
+};
+
+struct Point {
+    unsigned long ops = 0;
+    unsigned long long bytes = 0;
+    unsigned long sent = 0;
+    unsigned long lost = 0;
+    unsigned long zc_done = 0;
+    unsigned long zc_copied = 0;
+    uint64_t ns = 0;
+    LatencyHistogram hist;
+    bool failed = false;
+};
+
+// Parse "64,4K,1M" into bytes; empty on a malformed entry
+static vector<size_t> parse_sizes(const char* text) {
+    vector<size_t> out;
+    const char* p = text;
+    while (*p) {
+        char* end = nullptr;
+        unsigned long long v = strtoull(p, &end, 10);
+        if (end == p)
+            return {};
+        if (*end == 'K' || *end == 'k')
+            v <<= 10, ++end;
+        else if (*end == 'M' || *end == 'm')
+            v <<= 20, ++end;
+        if (v == 0 || (*end != ',' && *end != '\0'))
+            return {};
+        out.push_back(static_cast<size_t>(v));
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return out;
+}
+
+static string size_label(size_t bytes) {
+    char buf[32];
+    if (bytes >= (1u << 20) && bytes % (1u << 20) == 0)
+        snprintf(buf, sizeof(buf), "%zuM", bytes >> 20);
+    else if (bytes >= (1u << 10) && bytes % (1u << 10) == 0)
+        snprintf(buf, sizeof(buf), "%zuK", bytes >> 10);
+    else
+        snprintf(buf, sizeof(buf), "%zu", bytes);
+    return buf;
+}
+
+static void fail(const char* what) {
+    cerr << "netbench: " << what << ": " << strerror(errno) << endl;
+}
+
+// ------------------------------------------------------------- sockets ----
+static void set_timeout(int fd, int ms) {
+    struct timeval tv = {ms / 1000, (ms % 1000) * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+}
+
+static void set_nodelay(int fd) {
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+// A listening socket on 127.0.0.1:<ephemeral> or an abstract AF_UNIX name;
+// the address to connect to is returned in addr/len
+static int make_listener(const Config& cfg, int index, sockaddr_storage& addr, socklen_t& len) {
+    memset(&addr, 0, sizeof(addr));
+    int fd;
+    if (cfg.family == "tcp") {
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        auto* in = reinterpret_cast<sockaddr_in*>(&addr);
+        in->sin_family = AF_INET;
+        in->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        len = sizeof(*in);
+    } else {
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        auto* un = reinterpret_cast<sockaddr_un*>(&addr);
+        un->sun_family = AF_UNIX;
+        int n = snprintf(un->sun_path + 1, sizeof(un->sun_path) - 1, "ubnetbench-%d-%d", getpid(), index);
+        len = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 + n);
+    }
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&addr), len) < 0 || listen(fd, 1024) < 0) {
+        fail("listen");
+        exit(1);
+    }
+    getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    return fd;
+}
+
+static int connect_to(const Config& cfg, const sockaddr_storage& addr, socklen_t len) {
+    int fd = socket(cfg.family == "tcp" ? AF_INET : AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+    while (connect(fd, reinterpret_cast<const sockaddr*>(&addr), len) < 0) {
+        if (errno != EINTR) {
+            close(fd);
+            return -1;
+        }
+    }
+    return fd;
+}
+
+// A connected client/server socket pair of the configured family
+static bool make_pair(const Config& cfg, int index, int& client, int& server) {
+    if (cfg.family == "unix" || cfg.family == "unix-dgram") {
+        int sv[2];
+        if (socketpair(AF_UNIX, (cfg.family == "unix" ? SOCK_STREAM : SOCK_DGRAM) | SOCK_CLOEXEC, 0, sv) < 0)
+            return false;
+        client = sv[0];
+        server = sv[1];
+        return true;
+    }
+    if (cfg.family == "tcp") {
+        sockaddr_storage addr;
+        socklen_t len;
+        int lfd = make_listener(cfg, index, addr, len);
+        client = connect_to(cfg, addr, len);
+        server = client < 0 ? -1 : accept4(lfd, nullptr, nullptr, SOCK_CLOEXEC);
+        close(lfd);
+        if (client < 0 || server < 0)
+            return false;
+        set_nodelay(client);
+        set_nodelay(server);
+        return true;
+    }
+    // udp: two bound sockets connected to each other
+    sockaddr_in a = {}, b = {};
+    socklen_t alen = sizeof(a), blen = sizeof(b);
+    a.sin_family = b.sin_family = AF_INET;
+    a.sin_addr.s_addr = b.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    client = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    server = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (client < 0 || server < 0 ||
+        bind(client, reinterpret_cast<sockaddr*>(&a), alen) < 0 || bind(server, reinterpret_cast<sockaddr*>(&b), blen) < 0 ||
+        getsockname(client, reinterpret_cast<sockaddr*>(&a), &alen) < 0 ||
+        getsockname(server, reinterpret_cast<sockaddr*>(&b), &blen) < 0 ||
+        connect(client, reinterpret_cast<sockaddr*>(&b), blen) < 0 ||
+        connect(server, reinterpret_cast<sockaddr*>(&a), alen) < 0)
+        return false;
+    return true;
+}
+
+// Exactly len bytes on a stream socket; false on EOF or error
+static bool send_all(int fd, const char* buf, size_t len, int flags = 0) {
+    while (len > 0) {
+        ssize_t n = send(fd, buf, len, flags | MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        buf += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+static bool recv_all(int fd, char* buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = recv(fd, buf, len, 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        buf += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// ------------------------------------------------------------- workers ----
+struct Shared {
+    const Config* cfg;
+    size_t size;
+    const BenchTimer* timer;
+    std::atomic<bool> client_done{false};
+
+    // Start line: every thread is created and pinned before the window opens
+    std::mutex mu;
+    std::condition_variable cv;
+    int ready = 0;
+    bool go = false;
+};
+
+// Pin the calling thread, check in and sleep until run_point() opens the window
+static void arrive(Shared* sh, int cpu) {
+    pin_thread(cpu);
+    std::unique_lock<std::mutex> lk(sh->mu);
+    ++sh->ready;
+    sh->cv.notify_all();
+    sh->cv.wait(lk, [sh] { return sh->go; });
+}
+
+static void rr_client(Shared* sh, int fd, PairStats* st, int cpu) {
+    arrive(sh, cpu);
+    bool stream = is_stream(*sh->cfg);
+    vector<char> buf(sh->size, 'x');
+    if (!stream)
+        set_timeout(fd, 100);
+    while (!sh->timer->expired()) {
+        uint64_t t0 = now_ns();
+        if (stream) {
+            if (!send_all(fd, buf.data(), sh->size) || !recv_all(fd, buf.data(), sh->size)) {
+                st->failed = true;
+                break;
+            }
+        } else {
+            if (send(fd, buf.data(), sh->size, 0) < 0 && errno != ENOBUFS && errno != ECONNREFUSED) {
+                st->failed = true;
+                break;
+            }
+            if (recv(fd, buf.data(), sh->size, 0) < 0) {
+                if (errno == EAGAIN || errno == EINTR) {
+                    ++st->lost;
+                    continue;
+                }
+                st->failed = true;
+                break;
+            }
+        }
+        st->hist.record(now_ns() - t0);
+        ++st->ops;
+    }
+    sh->client_done.store(true, std::memory_order_release);
+    if (stream)
+        shutdown(fd, SHUT_WR);
+}
+
+static void rr_server(Shared* sh, int fd, PairStats*, int cpu) {
+    arrive(sh, cpu);
+    bool stream = is_stream(*sh->cfg);
+    vector<char> buf(sh->size);
+    if (!stream)
+        set_timeout(fd, DGRAM_TIMEOUT_MS);
+    for (;;) {
+        if (stream) {
+            if (!recv_all(fd, buf.data(), sh->size) || !send_all(fd, buf.data(), sh->size))
+                break;
+        } else {
+            ssize_t n = recv(fd, buf.data(), sh->size, 0);
+            if (n < 0) {
+                if ((errno == EAGAIN || errno == EINTR) && !sh->client_done.load(std::memory_order_acquire))
+                    continue;
+                break;
+            }
+            send(fd, buf.data(), static_cast<size_t>(n), 0);
+        }
+    }
+}
+
+// Count MSG_ZEROCOPY completions waiting on the error queue
+static void reap_zerocopy(int fd, PairStats* st) {
+    for (;;) {
+        char control[128];
+        struct msghdr msg = {};
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+            return;
+        for (struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+            auto* serr = reinterpret_cast<struct sock_extended_err*>(CMSG_DATA(cm));
+            if (serr->ee_errno != 0 || serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+                continue;
+            unsigned long range = serr->ee_data - serr->ee_info + 1;
+            st->zc_done += range;
+            if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+                st->zc_copied += range;
+        }
+    }
+}
+
+static void wait_errqueue(int fd, int ms) {
+    struct pollfd p = {fd, 0, 0};   // POLLERR is always reported
+    poll(&p, 1, ms);
+}
+
+// stream, mmsg and zerocopy senders
+static void stream_client(Shared* sh, int fd, PairStats* st, int cpu) {
+    arrive(sh, cpu);
+    const Config& cfg = *sh->cfg;
+    bool stream = is_stream(cfg);
+    bool zerocopy = cfg.mode == "zerocopy";
+    vector<char> buf(sh->size, 'x');
+
+    if (zerocopy) {
+        int one = 1;
+        if (setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) < 0) {
+            fail("SO_ZEROCOPY");
+            st->failed = true;
+        }
+    }
+    vector<struct mmsghdr> msgs;
+    vector<struct iovec> iovs;
+    if (cfg.mode == "mmsg") {
+        msgs.resize(cfg.batch);
+        iovs.resize(cfg.batch);
+        for (int i = 0; i < cfg.batch; ++i) {
+            iovs[i] = {buf.data(), sh->size};
+            msgs[i] = {};
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+    }
+
+    while (!st->failed && !sh->timer->expired()) {
+        if (cfg.mode == "mmsg") {
+            int n = sendmmsg(fd, msgs.data(), static_cast<unsigned>(cfg.batch), 0);
+            if (n < 0) {
+                if (errno == EINTR || errno == ENOBUFS || errno == ECONNREFUSED)
+                    continue;
+                fail("sendmmsg");
+                st->failed = true;
+                break;
+            }
+            st->sent += static_cast<unsigned long>(n);
+        } else if (zerocopy) {
+            // Sends the completion queue has not caught up with hold pinned pages
+            if (st->sent - st->zc_done >= ZC_OUTSTANDING) {
+                reap_zerocopy(fd, st);
+                if (st->sent - st->zc_done >= ZC_OUTSTANDING)
+                    wait_errqueue(fd, 1);
+                continue;
+            }
+            ssize_t n = send(fd, buf.data(), sh->size, MSG_ZEROCOPY | MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == ENOBUFS) {
+                    reap_zerocopy(fd, st);
+                    wait_errqueue(fd, 1);
+                    continue;
+                }
+                if (errno == EINTR || errno == ECONNREFUSED)
+                    continue;
+                fail("send MSG_ZEROCOPY");
+                st->failed = true;
+                break;
+            }
+            // A short TCP send still counts as one zerocopy notification; finish the rest by copy
+            if (stream && static_cast<size_t>(n) < sh->size &&
+                !send_all(fd, buf.data() + n, sh->size - static_cast<size_t>(n))) {
+                st->failed = true;
+                break;
+            }
+            ++st->sent;
+        } else if (stream) {
+            if (!send_all(fd, buf.data(), sh->size)) {
+                st->failed = true;
+                break;
+            }
+            ++st->sent;
+        } else {
+            if (send(fd, buf.data(), sh->size, 0) < 0) {
+                if (errno == EINTR || errno == ENOBUFS || errno == ECONNREFUSED)
+                    continue;
+                fail("send");
+                st->failed = true;
+                break;
+            }
+            ++st->sent;
+        }
+    }
+    if (zerocopy) {
+        uint64_t deadline = now_ns() + 1000000000ULL;
+        while (st->zc_done < st->sent && now_ns() < deadline) {
+            wait_errqueue(fd, 10);
+            reap_zerocopy(fd, st);
+        }
+    }
+    sh->client_done.store(true, std::memory_order_release);
+    if (stream)
+        shutdown(fd, SHUT_WR);
+}
+
+static void stream_server(Shared* sh, int fd, PairStats* st, int cpu) {
+    arrive(sh, cpu);
+    const Config& cfg = *sh->cfg;
+    bool stream = is_stream(cfg);
+    size_t chunk = stream ? max<size_t>(sh->size, 64 * 1024) : sh->size;
+    vector<char> buf(chunk * (cfg.mode == "mmsg" ? cfg.batch : 1));
+    vector<struct mmsghdr> msgs;
+    vector<struct iovec> iovs;
+    if (cfg.mode == "mmsg") {
+        msgs.resize(cfg.batch);
+        iovs.resize(cfg.batch);
+        for (int i = 0; i < cfg.batch; ++i) {
+            iovs[i] = {buf.data() + static_cast<size_t>(i) * chunk, chunk};
+            msgs[i] = {};
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+    }
+    if (!stream)
+        set_timeout(fd, DGRAM_TIMEOUT_MS);
+
+    for (;;) {
+        if (cfg.mode == "mmsg") {
+            int n = recvmmsg(fd, msgs.data(), static_cast<unsigned>(cfg.batch), MSG_WAITFORONE, nullptr);
+            if (n < 0) {
+                if ((errno == EAGAIN || errno == EINTR) && !sh->client_done.load(std::memory_order_acquire))
+                    continue;
+                break;
+            }
+            for (int i = 0; i < n; ++i)
+                st->bytes += msgs[i].msg_len;
+            st->ops += static_cast<unsigned long>(n);
+            continue;
+        }
+        ssize_t n = recv(fd, buf.data(), chunk, 0);
+        if (n < 0) {
+            if ((errno == EAGAIN || errno == EINTR) && (stream || !sh->client_done.load(std::memory_order_acquire)))
+                continue;
+            break;
+        }
+        if (n == 0 && stream)
+            break;
+        st->bytes += static_cast<unsigned long long>(n);
+        if (!stream)
+            ++st->ops;
+    }
+    if (stream)
+        st->ops = static_cast<unsigned long>(st->bytes / sh->size);
+}
+
+static void connect_client(Shared* sh, const sockaddr_storage* addr, socklen_t len, PairStats* st, int cpu) {
+    arrive(sh, cpu);
+    char c;
+    while (!sh->timer->expired()) {
+        int fd = connect_to(*sh->cfg, *addr, len);
+        if (fd < 0) {
+            if (errno == EINTR || errno == EAGAIN)
+                continue;
+            fail("connect");
+            st->failed = true;
+            break;
+        }
+        // The server closes first, so TIME_WAIT stays on its side and client ports recycle
+        while (recv(fd, &c, 1, 0) < 0 && errno == EINTR) {
+        }
+        close(fd);
+        ++st->ops;
+    }
+    sh->client_done.store(true, std::memory_order_release);
+}
+
+static void connect_server(Shared* sh, int lfd, PairStats*, int cpu) {
+    arrive(sh, cpu);
+    for (;;) {
+        int fd = accept4(lfd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            break;      // the listener was shut down
+        }
+        close(fd);
+    }
+}
+
+// ---------------------------------------------------------------- driver ----
+static Point run_point(const Config& cfg, size_t size, int pairs, const vector<int>& cpus, double seconds, bool gated) {
+    Point pt;
+    Shared sh;
+    sh.cfg = &cfg;
+    sh.size = size;
+    BenchTimer timer;
+    sh.timer = &timer;
+
+    vector<unique_ptr<PairStats>> stats;
+    vector<int> clients(pairs, -1), servers(pairs, -1);
+    vector<sockaddr_storage> addrs(pairs);
+    vector<socklen_t> lens(pairs);
+    for (int i = 0; i < pairs; ++i) {
+        stats.emplace_back(new PairStats);
+        bool ok;
+        if (cfg.mode == "connect") {
+            servers[i] = make_listener(cfg, i, addrs[i], lens[i]);
+            ok = true;
+        } else {
+            ok = make_pair(cfg, i, clients[i], servers[i]);
+        }
+        if (!ok) {
+            fail("socket pair");
+            exit(1);
+        }
+    }
+
+    vector<std::thread> threads;
+    for (int i = 0; i < pairs; ++i) {
+        int scpu = cpus[(2 * i) % cpus.size()], ccpu = cpus[(2 * i + 1) % cpus.size()];
+        PairStats* st = stats[i].get();
+        if (cfg.mode == "rr") {
+            threads.emplace_back(rr_server, &sh, servers[i], st, scpu);
+            threads.emplace_back(rr_client, &sh, clients[i], st, ccpu);
+        } else if (cfg.mode == "connect") {
+            threads.emplace_back(connect_server, &sh, servers[i], st, scpu);
+            threads.emplace_back(connect_client, &sh, &addrs[i], lens[i], st, ccpu);
+        } else {
+            threads.emplace_back(stream_server, &sh, servers[i], st, scpu);
+            threads.emplace_back(stream_client, &sh, clients[i], st, ccpu);
+        }
+    }
+    {
+        std::unique_lock<std::mutex> lk(sh.mu);
+        sh.cv.wait(lk, [&] { return sh.ready == static_cast<int>(threads.size()); });
+        timer.start(seconds, gated);
+        sh.go = true;
+    }
+    sh.cv.notify_all();
+    // Clients stop on the timer; servers follow on EOF, their receive timeout or shutdown()
+    for (size_t t = 1; t < threads.size(); t += 2)
+        threads[t].join();
+    pt.ns = timer.stop();
+    if (cfg.mode == "connect") {
+        for (int fd : servers)
+            shutdown(fd, SHUT_RDWR);
+    }
+    for (size_t t = 0; t < threads.size(); t += 2)
+        threads[t].join();
+
+    for (int i = 0; i < pairs; ++i) {
+        const PairStats& st = *stats[i];
+        pt.ops += st.ops;
+        pt.bytes += st.bytes;
+        pt.sent += st.sent;
+        pt.lost += st.lost;
+        pt.zc_done += st.zc_done;
+        pt.zc_copied += st.zc_copied;
+        pt.hist.merge(st.hist);
+        pt.failed = pt.failed || st.failed;
+        if (clients[i] >= 0)
+            close(clients[i]);
+        close(servers[i]);
+    }
+    return pt;
+}
+
+static void usage(const char* prog) {
+    cerr << "Usage: " << prog << " [-m rr|stream|connect|mmsg|zerocopy] [-f tcp|udp|unix|unix-dgram] [-s sizes]"
+         << " [-B batch] [-P pairs] [-p policy] duration" << endl;
+    exit(1);
+}
+
+int main(int argc, char* argv[]) {
+    Config cfg;
+    vector<size_t> sizes;
+    int max_pairs = 1;
+    string policy = "compact";
+
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; ++arg) {
+        if (strcmp(argv[arg], "-m") == 0 && arg + 1 < argc)
+            cfg.mode = argv[++arg];
+        else if (strcmp(argv[arg], "-f") == 0 && arg + 1 < argc)
+            cfg.family = argv[++arg];
+        else if (strcmp(argv[arg], "-s") == 0 && arg + 1 < argc) {
+            sizes = parse_sizes(argv[++arg]);
+            if (sizes.empty())
+                usage(argv[0]);
+        } else if (strcmp(argv[arg], "-B") == 0 && arg + 1 < argc)
+            cfg.batch = atoi(argv[++arg]);
+        else if (strcmp(argv[arg], "-P") == 0 && arg + 1 < argc)
+            max_pairs = atoi(argv[++arg]);
+        else if (strcmp(argv[arg], "-p") == 0 && arg + 1 < argc)
+            policy = argv[++arg];
+        else
+            usage(argv[0]);
+    }
+    bool family_ok = cfg.family == "tcp" || cfg.family == "udp" || cfg.family == "unix" || cfg.family == "unix-dgram";
+    bool mode_ok = cfg.mode == "rr" || cfg.mode == "stream" ||
+                   (cfg.mode == "connect" && is_stream(cfg)) ||
+                   (cfg.mode == "mmsg" && !is_stream(cfg)) ||
+                   (cfg.mode == "zerocopy" && (cfg.family == "tcp" || cfg.family == "udp"));
+    if (arg + 1 != argc || !family_ok || !mode_ok || max_pairs < 1 || cfg.batch < 1 || cfg.batch > MAX_BATCH)
+        usage(argv[0]);
+    double duration = parse_duration(argv[arg]);
+    if (duration <= 0) {
+        cerr << "Invalid duration: " << argv[arg] << endl;
+        exit(1);
+    }
+
+    if (sizes.empty()) {
+        if (cfg.mode == "rr" || cfg.mode == "connect")
+            sizes = {64};
+        else if (cfg.mode == "mmsg")
+            sizes = {64, 1u << 10};
+        else
+            sizes = {64, 1u << 10, 16u << 10, 60u << 10};
+    }
+    if (cfg.mode == "connect")
+        sizes = {0};    // nothing is transferred
+    for (size_t s : sizes) {
+        if (!is_stream(cfg) && s > MAX_DATAGRAM) {
+            cerr << "netbench: " << s << " bytes is more than one datagram (" << MAX_DATAGRAM << ")" << endl;
+            exit(1);
+        }
+    }
+
+    vector<int> pair_counts;
+    for (int p = 1; p < max_pairs; p *= 2)
+        pair_counts.push_back(p);
+    pair_counts.push_back(max_pairs);
+    vector<int> cpus = place_cpus(policy, 2 * max_pairs);
+    if (cpus.empty())
+        usage(argv[0]);
+
+    signal(SIGPIPE, SIG_IGN);
+    process_counters().open();  // before the threads, so both sides are counted
+
+    size_t points = sizes.size() * pair_counts.size();
+    double slice = points > 1 ? max(duration / static_cast<double>(points), 0.05) : duration;
+    bool datagram = !is_stream(cfg);
+    printf("netbench: %s over %s, placement %s, %.3f s per point\n", cfg.mode.c_str(), cfg.family.c_str(),
+           policy.c_str(), slice);
+    printf("%8s %6s %14s %10s %10s %10s\n", "message", "pairs", "ops/s", "Gbit/s", "p50 us", "p99 us");
+
+    BenchResult result(bench_name(argv[0]), 0, 0, cfg.mode == "rr" ? "trans" : cfg.mode == "connect" ? "conns" : "msgs");
+    result.tag("mode", cfg.mode);
+    result.tag("family", cfg.family);
+    result.tag("placement", policy);
+    if (cfg.mode == "mmsg")
+        result.add("batch", cfg.batch, "config");
+    bool first = true;
+    int failures = 0;
+
+    for (size_t size : sizes) {
+        for (int pairs : pair_counts) {
+            Point pt = run_point(cfg, size, pairs, cpus, slice, first);
+            first = false;
+            if (pt.failed)
+                ++failures;
+            double secs = static_cast<double>(pt.ns) / 1e9;
+            double ops_per_sec = static_cast<double>(pt.ops) / secs;
+            // rr moves the message both ways
+            double bytes = cfg.mode == "rr" ? 2.0 * static_cast<double>(pt.ops) * static_cast<double>(size)
+                                            : static_cast<double>(pt.bytes);
+            double gbits = bytes * 8 / secs / 1e9;
+            double p50 = pt.hist.samples() ? static_cast<double>(pt.hist.percentile(0.50)) / 1000.0 : 0;
+            double p99 = pt.hist.samples() ? static_cast<double>(pt.hist.percentile(0.99)) / 1000.0 : 0;
+            printf("%8s %6d %14.0f %10.3f %10.2f %10.2f\n", size_label(size).c_str(), pairs, ops_per_sec, gbits, p50, p99);
+
+            BenchResult point(bench_name(argv[0]), 0, 0, result.unit.c_str());
+            BenchResult& r = points > 1 ? point : result;
+            r.count = static_cast<double>(pt.ops);
+            r.iterations = pt.ops;
+            r.elapsed_ns = pt.ns;
+            const char* group = points > 1 ? "point" : "net";
+            r.add("message_bytes", static_cast<double>(size), group);
+            r.add("pairs", pairs, group);
+            r.add("ops_per_sec", ops_per_sec, group);
+            if (cfg.mode != "connect")
+                r.add("gbits", gbits, group);
+            if (datagram && cfg.mode != "rr")
+                r.add("delivered", pt.sent ? static_cast<double>(pt.ops) / static_cast<double>(pt.sent) : 0.0, group);
+            if (cfg.mode == "rr" && datagram)
+                r.add("lost", static_cast<double>(pt.lost), group);
+            if (cfg.mode == "zerocopy") {
+                r.add("zc_completions", static_cast<double>(pt.zc_done), group);
+                r.add("zc_copied", pt.zc_done ? static_cast<double>(pt.zc_copied) / static_cast<double>(pt.zc_done) : 0.0, group);
+            }
+            if (cfg.mode == "rr")
+                report_histogram(r, pt.hist, 1.0);
+
+            if (points > 1) {
+                r.tag("mode", cfg.mode);
+                r.tag("family", cfg.family);
+                emit_json(r);
+                result.add("m" + size_label(size) + "_p" + to_string(pairs), ops_per_sec, "ops_per_sec");
+                // Headline: the first size at the most pairs
+                if (size == sizes.front() && pairs == max_pairs) {
+                    result.count = static_cast<double>(pt.ops);
+                    result.iterations = pt.ops;
+                    result.elapsed_ns = pt.ns;
+                }
+            }
+        }
+    }
+    fflush(stdout);
+    emit_result(result);
+    return failures ? 2 : 0;
+}
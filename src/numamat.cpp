@@ -0,0 +1,191 @@
+/**
+ * @file        numamat.cpp
+ * @brief       Cross-node memory bandwidth and latency matrix
+ * @author      rRNA
+ * @version     4.0.0
+ * @date        10-17-2026
+ *
+ * @details
+ * For every pair (CPU node i, memory node j) the calling thread is pinned to
+ * a CPU of node i and a buffer is bound to node j with mbind(MPOL_BIND), then
+ *
+ *   - read bandwidth is measured by summing the buffer (MB/s, 10^6 bytes), and
+ *   - latency by a dependent pointer chase over a random ring of cache lines.
+ *
+ * The diagonal is local access, everything else crosses the interconnect. The
+ * COUNT| result is the mean local bandwidth; the remote/local ratios are in the
+ * structured result so placement regressions show up as numbers.
+ *
+ * Usage:
+ *   numamat [-s size_mib] duration
+ */
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <sys/mman.h>
+
+#include "timeit.hpp"
+#include "result.hpp"
+#include "topology.hpp"
+#include "memchase.hpp"
+
+using namespace std;
+
+static volatile uint64_t sink;
+
+// Sum the buffer with four independent accumulators so the loads, not the adds, are the limit
+static uint64_t read_pass(const uint64_t* p, size_t words) {
+    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    for (size_t i = 0; i < words; i += 4) {
+        s0 += p[i];
+        s1 += p[i + 1];
+        s2 += p[i + 2];
+        s3 += p[i + 3];
+    }
+    return s0 + s1 + s2 + s3;
+}
+
+static void usage(const char* prog) {
+    cerr << "Usage: " << prog << " [-s size_mib] duration" << endl;
+    cerr << "  -s size_mib  buffer size per measurement (default 4 x LLC, at least 256)" << endl;
+    cerr << "duration is the total time in seconds, shared by all node pairs" << endl;
+    exit(1);
+}
+
+int main(int argc, char* argv[]) {
+    size_t bytes = 0;
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; ++arg) {
+        if (strcmp(argv[arg], "-s") == 0 && arg + 1 < argc)
+            bytes = static_cast<size_t>(strtoull(argv[++arg], nullptr, 10)) << 20;
+        else
+            usage(argv[0]);
+    }
+    if (arg >= argc)
+        usage(argv[0]);
+    double duration = parse_duration(argv[arg]);
+    if (duration <= 0) {
+        cerr << "Invalid duration: " << argv[arg] << endl;
+        exit(1);
+    }
+    if (bytes == 0)
+        bytes = max<size_t>(4 * llc_size(), 256u << 20);
+    bytes &= ~(size_t(4095));
+
+    // CPU nodes we may run on, memory nodes we may allocate from
+    vector<int> mem_nodes = numa_nodes();
+    vector<int> cpu_nodes;
+    vector<int> cpu_of_node;
+    for (int node : mem_nodes) {
+        vector<int> cpus = node_cpus(node);
+        if (!cpus.empty()) {
+            cpu_nodes.push_back(node);
+            cpu_of_node.push_back(cpus.front());
+        }
+    }
+    if (cpu_nodes.empty()) {
+        cpu_nodes.push_back(mem_nodes.front());
+        cpu_of_node.push_back(allowed_cpus().empty() ? -1 : allowed_cpus().front());
+    }
+    double slice = max(duration / static_cast<double>(2 * cpu_nodes.size() * mem_nodes.size()), 0.05);
+
+    printf("numamat: %zu CPU node(s) x %zu memory node(s), %zu MiB buffer\n",
+           cpu_nodes.size(), mem_nodes.size(), bytes >> 20);
+    printf("%-8s %-8s %12s %10s\n", "cpu", "memory", "MB/s", "ns/load");
+
+    mt19937_64 rng(0x5eed);
+    BenchResult result;
+    result.name = "numamat";
+    result.unit = "MBps";
+    double local_sum = 0, local_n = 0;
+    uint64_t total_ns = 0;
+    bool first = true;
+
+    for (size_t ci = 0; ci < cpu_nodes.size(); ++ci) {
+        pin_thread(cpu_of_node[ci]);
+        double local_mbps = 0, local_lat = 0;
+        vector<pair<int, pair<double, double>>> row;
+
+        for (int mnode : mem_nodes) {
+            void* map = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (map == MAP_FAILED) {
+                cerr << "numamat: cannot map " << (bytes >> 20) << " MiB" << endl;
+                exit(1);
+            }
+            bool bound = mbind_node(map, bytes, mnode);
+            char* buf = static_cast<char*>(map);
+            memset(buf, 1, bytes);      // fault in on the bound node
+
+            // Bandwidth: whole passes over the buffer
+            BenchTimer timer;
+            timer.start(slice, first);
+            first = false;
+            unsigned long passes = 0;
+            while (!timer.expired()) {
+                sink = read_pass(reinterpret_cast<const uint64_t*>(buf), bytes / sizeof(uint64_t));
+                ++passes;
+            }
+            uint64_t bw_ns = timer.stop();
+            double mbps = static_cast<double>(bytes) * static_cast<double>(passes) / (static_cast<double>(bw_ns) / 1e9) / 1e6;
+
+            // Latency: dependent loads over the same pages
+            void* p = build_ring(buf, bytes, rng);
+            timer.start(slice, false);
+            unsigned long loads = 0;
+            while (!timer.expired()) {
+                p = chase(p, 1024);
+                loads += 1024;
+            }
+            uint64_t lat_ns = timer.stop();
+            sink = reinterpret_cast<uintptr_t>(p);
+            double ns_per_load = static_cast<double>(lat_ns) / static_cast<double>(loads);
+            munmap(map, bytes);
+            total_ns += bw_ns + lat_ns;
+
+            printf("%-8d %-8d %12.1f %10.2f%s\n", cpu_nodes[ci], mnode, mbps, ns_per_load, bound ? "" : "  (mbind failed)");
+
+            BenchResult r("numamat", passes, bw_ns, "MBps");
+            r.count = mbps;
+            r.tag("bound", bound ? "yes" : "no");
+            r.add("cpu_node", cpu_nodes[ci], "point");
+            r.add("mem_node", mnode, "point");
+            r.add("cpu", cpu_of_node[ci], "point");
+            r.add("ns_per_load", ns_per_load, "point");
+            emit_json(r);
+
+            string key = "n" + to_string(cpu_nodes[ci]) + "_m" + to_string(mnode);
+            result.add(key, mbps, "bandwidth_mbps");
+            result.add(key, ns_per_load, "latency_ns");
+            if (mnode == cpu_nodes[ci]) {
+                local_mbps = mbps;
+                local_lat = ns_per_load;
+                local_sum += mbps;
+                local_n += 1;
+            }
+            row.push_back({mnode, {mbps, ns_per_load}});
+        }
+
+        // Remote cost relative to this node's local access
+        for (const auto& cell : row) {
+            if (cell.first == cpu_nodes[ci] || local_mbps <= 0)
+                continue;
+            string key = "n" + to_string(cpu_nodes[ci]) + "_m" + to_string(cell.first);
+            result.add(key + "_bw", cell.second.first / local_mbps, "remote_ratio");
+            result.add(key + "_lat", cell.second.second / local_lat, "remote_ratio");
+        }
+    }
+    fflush(stdout);
+
+    result.count = local_n > 0 ? local_sum / local_n : 0;
+    result.elapsed_ns = total_ns;
+    result.add("buffer_bytes", static_cast<double>(bytes), "config");
+    result.add("cpu_nodes", static_cast<double>(cpu_nodes.size()), "config");
+    result.add("mem_nodes", static_cast<double>(mem_nodes.size()), "config");
+    emit_result(result);
+    return 0;
+}
@@ -0,0 +1,211 @@
+/**
+ * @file        perfcount.cpp
+ * @brief       Hardware performance counters (perf_event_open) around measured loops
+ * @author      rRNA
+ * @version     4.0.0
+ * @date        10-17-2026
+ *
+ * @details
+ * Every event is opened on its own rather than as one group: six hardware
+ * events do not fit on every PMU at once, so the kernel multiplexes them and
+ * each reading is scaled by time_enabled / time_running.
+ */
+
+#include "perfcount.hpp"
+#include "result.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+
+namespace {
+
+struct EventSpec {
+    const char* name;
+    uint32_t type;
+    uint64_t config;
+};
+
+constexpr uint64_t cache_miss(uint64_t cache) {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+const EventSpec specs[] = {
+    {"cycles",        PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions",  PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {"l1d_misses",    PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_L1D)},
+    {"llc_misses",    PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_LL)},
+    {"dtlb_misses",   PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_DTLB)},
+    // Software events work without a PMU (most VMs) and explain scheduler-bound scores
+    {"context_switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+    {"page_faults",      PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+};
+
+int open_event(const EventSpec& spec, bool user_only) {
+    struct perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = spec.type;
+    attr.config = spec.config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_hv = 1;
+    attr.exclude_kernel = user_only ? 1 : 0;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+}
+
+}  // namespace
+
+PerfCounters::~PerfCounters() {
+    for (const auto& e : events)
+        close(e.fd);
+}
+
+bool PerfCounters::requested() const {
+    const char* env = std::getenv("UB_PERF");
+    return env != nullptr && *env != '\0' && std::strcmp(env, "0") != 0;
+}
+
+bool PerfCounters::open() {
+    if (opened)
+        return !events.empty();
+    opened = true;
+    if (!requested())
+        return false;
+
+    // Descriptors inherited from the previous image (execl)
+    if (const char* fds = std::getenv("UB_PERF_FDS")) {
+        std::string list = fds;
+        size_t colon = list.find(':');
+        scope = list.substr(0, colon);
+        while (colon != std::string::npos) {
+            size_t eq = list.find('=', colon + 1);
+            size_t next = list.find(',', colon + 1);
+            if (eq == std::string::npos)
+                break;
+            std::string name = list.substr(colon + 1, eq - colon - 1);
+            int fd = std::atoi(list.c_str() + eq + 1);
+            for (const auto& spec : specs) {
+                // The window began in the previous image, so the baseline stays zero
+                if (name == spec.name && fcntl(fd, F_GETFD) >= 0)
+                    events.push_back({spec.name, fd, {0, 0, 0}});
+            }
+            colon = next;
+        }
+        if (!events.empty()) {
+            ++windows;  // the previous image already counted
+            running = true;
+            return true;
+        }
+    }
+
+    const char* env = std::getenv("UB_PERF");
+    bool user_only = std::strcmp(env, "user") == 0;
+    for (int attempt = 0; attempt < 2 && events.empty(); ++attempt) {
+        for (const auto& spec : specs) {
+            int fd = open_event(spec, user_only);
+            if (fd >= 0) {
+                events.push_back({spec.name, fd, {0, 0, 0}});
+            } else if (error.empty() || errno == EACCES || errno == EPERM) {
+                error = std::string(spec.name) + ": " + std::strerror(errno);
+            }
+        }
+        if (events.empty() && !user_only && (errno == EACCES || errno == EPERM)) {
+            user_only = true;   // perf_event_paranoid >= 2 allows user-space counting only
+            continue;
+        }
+        break;
+    }
+    scope = user_only ? "user" : "user+kernel";
+    return !events.empty();
+}
+
+void PerfCounters::start() {
+    if (!open() || running)
+        return;
+    for (auto& e : events) {
+        if (::read(e.fd, e.base, sizeof(e.base)) != static_cast<ssize_t>(sizeof(e.base)))
+            e.base[0] = e.base[1] = e.base[2] = 0;
+        ioctl(e.fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    running = true;
+    ++windows;
+}
+
+void PerfCounters::stop() {
+    if (!running)
+        return;
+    for (const auto& e : events)
+        ioctl(e.fd, PERF_EVENT_IOC_DISABLE, 0);
+    running = false;
+}
+
+// Counts since the last start(), scaled for multiplexing within that window
+bool PerfCounters::read(const Event& e, Reading& out) const {
+    uint64_t buf[3];
+    if (::read(e.fd, buf, sizeof(buf)) != static_cast<ssize_t>(sizeof(buf)))
+        return false;
+    uint64_t value = buf[0] - e.base[0];
+    uint64_t enabled = buf[1] - e.base[1];
+    uint64_t on_pmu = buf[2] - e.base[2];
+    if (on_pmu == 0)
+        return false;
+    out.running_ratio = static_cast<double>(on_pmu) / static_cast<double>(enabled);
+    out.value = static_cast<double>(value) / out.running_ratio;
+    return true;
+}
+
+void PerfCounters::report(BenchResult& r) const {
+    if (!requested())
+        return;
+    if (!captured()) {
+        r.tag("perf", "unavailable");
+        if (!error.empty())
+            r.tag("perf_error", error);
+        return;
+    }
+
+    r.tag("perf_scope", scope);
+    double cycles = 0, instructions = 0, coverage = 1.0;
+    for (const auto& e : events) {
+        Reading v;
+        if (!read(e, v))
+            continue;
+        r.add(e.name, v.value, "perf");
+        if (r.iterations > 0)
+            r.add(std::string(e.name) + "_per_iter", v.value / static_cast<double>(r.iterations), "perf");
+        if (std::strcmp(e.name, "cycles") == 0)
+            cycles = v.value;
+        else if (std::strcmp(e.name, "instructions") == 0)
+            instructions = v.value;
+        if (v.running_ratio < coverage)
+            coverage = v.running_ratio;
+    }
+    if (cycles > 0)
+        r.add("ipc", instructions / cycles, "perf");
+    // Lowest fraction of the window any event was actually on the PMU (< 1 means multiplexed)
+    r.add("coverage", coverage, "perf");
+}
+
+void PerfCounters::export_across_exec() {
+    if (!open())
+        return;
+    std::string list = scope;
+    for (const auto& e : events) {
+        fcntl(e.fd, F_SETFD, 0);
+        list += std::string(list.size() == scope.size() ? ":" : ",") + e.name + "=" + std::to_string(e.fd);
+    }
+    setenv("UB_PERF_FDS", list.c_str(), 1);
+}
+
+PerfCounters& process_counters() {
+    static PerfCounters counters;
+    return counters;
+}
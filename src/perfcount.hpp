@@ -0,0 +1,86 @@
+/**
+ * @file        perfcount.hpp
+ * @brief       Hardware performance counters (perf_event_open) around measured loops
+ * @author      rRNA
+ * @version     4.0.0
+ * @date        10-17-2026
+ *
+ * @details
+ * When UB_PERF is set, PerfCounters opens cycles, instructions, branch-misses,
+ * L1d read misses, LLC read misses and dTLB read misses, plus the context
+ * switch and page fault software events, for the calling process. The
+ * counters are inherited by children forked or threads created afterwards
+ * (spawn, looper, the unixbench workers) and are folded back into the parent
+ * when those exit. Counting is only enabled between start() and stop(), and
+ * start() takes a baseline, so a report covers the last window only: every
+ * point of a sweep carries its own counts, matching its iterations.
+ *
+ * BenchTimer drives the process-wide instance, and the result emitter adds its
+ * readings as a "perf" group (raw totals, IPC, and per-iteration values), so
+ * every benchmark built on BenchTimer is covered without changes.
+ *
+ *   UB_PERF=1      count user and kernel, falling back to user-only if the
+ *                  kernel refuses (perf_event_paranoid)
+ *   UB_PERF=user   count user space only
+ *
+ * Events the PMU does not support are skipped. If nothing can be opened the
+ * result is tagged perf=unavailable and the benchmark runs unchanged.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct BenchResult;
+
+class PerfCounters {
+public:
+    PerfCounters() = default;
+    ~PerfCounters();
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // Open the counters (disabled) if UB_PERF asks for them. Safe to call repeatedly.
+    // Counters handed over by export_across_exec() are adopted instead of reopened.
+    bool open();
+
+    void start();
+    void stop();
+
+    // Counters were requested and have counted at least one window
+    bool captured() const { return windows > 0 && !events.empty(); }
+    bool requested() const;
+    // open() has been called, i.e. this instance is in use
+    bool attempted() const { return opened; }
+
+    // Adds the "perf" group (and perf_scope / perf tags) to r
+    void report(BenchResult& r) const;
+
+    // Keep the counters open across execve() of the same task: clears close-on-exec and
+    // records the descriptors in UB_PERF_FDS for the next image's open() to adopt
+    void export_across_exec();
+
+private:
+    struct Event {
+        const char* name;
+        int fd;
+        uint64_t base[3];   // value, time enabled, time running at start()
+    };
+    struct Reading {
+        double value;
+        double running_ratio;
+    };
+    bool read(const Event& e, Reading& out) const;
+
+    std::vector<Event> events;
+    std::string scope;
+    std::string error;
+    int windows = 0;
+    bool opened = false;
+    bool running = false;
+};
+
+// The instance BenchTimer starts and stops and emit_result()/emit_json() report
+PerfCounters& process_counters();
@@ -9,59 +9,334 @@
  * This file is a C++ rewrite of pipe.c from the original UnixBench project.
  * Original project address: https://github.com/kdlucas/byte-unixbench/tree/v5.1.3
  *
+ * Without options this is the original test: one process writes and reads back
+ * a 512 byte buffer, which mostly measures system call entry. The options turn
+ * it into a throughput test:
  *
+ *   -s sizes   message sizes, comma separated with K/M suffixes (64 .. 1M)
+ *   -c sizes   pipe capacities set with F_SETPIPE_SZ (default: the kernel's)
+ *   -S         sweep: all message sizes 64 B .. 1 MiB and capacities 16K .. 1M
+ *   -m mode    single (one process, the default), process (forked producer)
+ *              or thread (producer thread)
+ *   -z         zero copy: vmsplice() from the producer's buffer and splice()
+ *              to /dev/null instead of write() and read()
  *
+ * Every (size, capacity) pair reports messages per second and GB/s (10^9
+ * bytes). With one pair the COUNT| line keeps the original unit, messages per
+ * second; with several the points go out as JSON lines and COUNT| is the best
+ * MB/s.
+ *
+ * The zero-copy producer reuses its buffer while earlier pages may still sit
+ * in the pipe. The payload is never looked at, so that is fine here, but it is
+ * not a pattern for real data.
  */
 
 #include <iostream>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <cerrno>
+#include <csignal>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
 #include <unistd.h>
-#include "timeit.cpp"  // The wake_me function is defined in timeit.cpp
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include "timeit.hpp"  // BenchTimer lives in the ubcommon library
+#include "result.hpp"
+#include "histogram.hpp"
+#include "perfcount.hpp"
 
 using namespace std;
 
 unsigned long iter;
 
-void report(int sig) {
-    std::cerr << "COUNT|" << iter << "|1|lps" << std::endl;
-    exit(0);
+struct Config {
+    string mode = "single";
+    bool zero_copy = false;
+    int devnull = -1;
+};
+
+struct Point {
+    unsigned long messages = 0;
+    unsigned long long bytes = 0;
+    uint64_t ns = 0;
+    int pipe_bytes = 0;
+};
+
+// Parse "64,4K,1M" into bytes; empty on a malformed entry
+static vector<size_t> parse_sizes(const char* text) {
+    vector<size_t> out;
+    const char* p = text;
+    while (*p) {
+        char* end = nullptr;
+        unsigned long long v = strtoull(p, &end, 10);
+        if (end == p)
+            return {};
+        if (*end == 'K' || *end == 'k')
+            v <<= 10, ++end;
+        else if (*end == 'M' || *end == 'm')
+            v <<= 20, ++end;
+        if (v == 0 || (*end != ',' && *end != '\0'))
+            return {};
+        out.push_back(static_cast<size_t>(v));
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return out;
 }
 
-int main(int argc, char* argv[]) {
-    char buf[512];
-    int pvec[2];
-    int duration;
+static string size_label(size_t bytes) {
+    char buf[32];
+    if (bytes >= (1u << 20) && bytes % (1u << 20) == 0)
+        snprintf(buf, sizeof(buf), "%zuM", bytes >> 20);
+    else if (bytes >= (1u << 10) && bytes % (1u << 10) == 0)
+        snprintf(buf, sizeof(buf), "%zuK", bytes >> 10);
+    else
+        snprintf(buf, sizeof(buf), "%zu", bytes);
+    return buf;
+}
 
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " duration" << std::endl;
-        exit(1);
+// Push exactly len bytes into the pipe; false once the reader is gone
+static bool put(int fd, char* buf, size_t len, bool zero_copy) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n;
+        if (zero_copy) {
+            struct iovec iov = {buf + done, len - done};
+            n = vmsplice(fd, &iov, 1, 0);
+        } else {
+            n = write(fd, buf + done, len - done);
+        }
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        done += static_cast<size_t>(n);
     }
+    return true;
+}
 
-    duration = atoi(argv[1]);
+// Take up to len bytes out of the pipe, into buf or (zero copy) straight to /dev/null
+static ssize_t take(int fd, char* buf, size_t len, const Config& cfg) {
+    ssize_t n;
+    do {
+        if (cfg.zero_copy)
+            n = splice(fd, nullptr, cfg.devnull, nullptr, len, SPLICE_F_MOVE);
+        else
+            n = read(fd, buf, len);
+    } while (n < 0 && errno == EINTR);
+    return n;
+}
+
+static void produce(int fd, char* buf, size_t size, bool zero_copy) {
+    while (put(fd, buf, size, zero_copy)) {
+    }
+}
+
+static Point run_point(const Config& cfg, size_t size, size_t capacity, double seconds, bool gated, BenchResult& lat_result) {
+    int pvec[2];
+    Point pt;
 
     // Create a pipeline. If the creation fails, output an error message and exit.
     if (pipe(pvec) == -1) {
         std::cerr << "pipe creation failed, error " << errno << std::endl;
         exit(1);
     }
+    if (capacity && fcntl(pvec[1], F_SETPIPE_SZ, static_cast<int>(capacity)) < 0)
+        std::cerr << "F_SETPIPE_SZ " << capacity << " failed, error " << errno << std::endl;
+    pt.pipe_bytes = fcntl(pvec[1], F_GETPIPE_SZ);
+
+    // Page aligned, so a zero-copy chunk of the pipe's capacity needs exactly capacity/4096 slots
+    char* buf = static_cast<char*>(aligned_alloc(4096, (size + 4095) & ~size_t(4095)));
+    memset(buf, 'x', size);
+
+    if (cfg.mode == "single") {
+        // A message larger than the pipe goes through in capacity-sized chunks
+        size_t chunk = min(size, static_cast<size_t>(pt.pipe_bytes > 0 ? pt.pipe_bytes : 4096));
+        LatencyRecorder lat;    // UB_LAT_SAMPLE=N times every Nth write/read pair
+
+        // Arm the measurement window; the loop stops once the timer sets the stop flag.
+        BenchTimer timer;
+        timer.start(seconds, gated);
+        iter = 0;
 
-    // Call wake_me to set a timer, and call the report function after duration seconds have passed.
-    wake_me(duration, report);
-    iter = 0;
+        // The pipeline data is continuously written and read in a loop, and the counter iter is continuously increased.
+        while (!timer.expired()) {
+            lat.begin();
+            for (size_t off = 0; off < size; off += chunk) {
+                size_t len = min(chunk, size - off);
+                if (!put(pvec[1], buf + off, len, cfg.zero_copy))
+                    std::cerr << "write failed, error " << errno << std::endl;
+                for (size_t got = 0; got < len;) {
+                    ssize_t n = take(pvec[0], buf + off, len - got, cfg);
+                    if (n <= 0) {
+                        std::cerr << "read failed, error " << errno << std::endl;
+                        break;
+                    }
+                    got += static_cast<size_t>(n);
+                }
+            }
+            lat.end();
+            iter++;
+        }
+        pt.ns = timer.stop();
+        pt.messages = iter;
+        pt.bytes = static_cast<unsigned long long>(iter) * size;
+        lat.report(lat_result);
+        close(pvec[0]);
+        close(pvec[1]);
+        free(buf);
+        return pt;
+    }
 
-    // The pipeline data is continuously written and read in a loop, and the counter iter is continuously increased.
-    while (true) {
-        if (write(pvec[1], buf, sizeof(buf)) != sizeof(buf)) {
-            if (errno != EINTR && errno != 0)
-                std::cerr << "write failed, error " << errno << std::endl;
+    // Producer/consumer: the producer writes until the reader closes the pipe (EPIPE)
+    pid_t child = -1;
+    std::thread producer;
+    if (cfg.mode == "process") {
+        child = fork();
+        if (child == 0) {
+            close(pvec[0]);
+            produce(pvec[1], buf, size, cfg.zero_copy);
+            _exit(0);
         }
-        if (read(pvec[0], buf, sizeof(buf)) != sizeof(buf)) {
-            if (errno != EINTR && errno != 0)
-                std::cerr << "read failed, error " << errno << std::endl;
+        close(pvec[1]);
+    } else {
+        producer = std::thread(produce, pvec[1], buf, size, cfg.zero_copy);
+    }
+
+    char* rbuf = static_cast<char*>(aligned_alloc(4096, (size + 4095) & ~size_t(4095)));
+    BenchTimer timer;
+    timer.start(seconds, gated);
+    while (!timer.expired()) {
+        ssize_t n = take(pvec[0], rbuf, size, cfg);
+        if (n <= 0) {
+            std::cerr << "read failed, error " << errno << std::endl;
+            break;
         }
-        iter++;
+        pt.bytes += static_cast<unsigned long long>(n);
     }
+    pt.ns = timer.stop();
+    pt.messages = static_cast<unsigned long>(pt.bytes / size);
 
+    close(pvec[0]);     // Producer sees EPIPE and stops
+    if (child > 0) {
+        waitpid(child, nullptr, 0);
+    } else {
+        producer.join();
+        close(pvec[1]);
+    }
+    free(rbuf);
+    free(buf);
+    return pt;
+}
+
+static void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [-s sizes] [-c capacities] [-S] [-m single|process|thread] [-z] duration" << std::endl;
+    exit(1);
+}
+
+int main(int argc, char* argv[]) {
+    Config cfg;
+    vector<size_t> sizes = {512};
+    vector<size_t> capacities = {0};    // 0: leave the kernel default
+    double duration;
+
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; ++arg) {
+        if (strcmp(argv[arg], "-s") == 0 && arg + 1 < argc) {
+            sizes = parse_sizes(argv[++arg]);
+        } else if (strcmp(argv[arg], "-c") == 0 && arg + 1 < argc) {
+            capacities = parse_sizes(argv[++arg]);
+        } else if (strcmp(argv[arg], "-S") == 0) {
+            sizes = {64, 256, 1u << 10, 4u << 10, 16u << 10, 64u << 10, 256u << 10, 1u << 20};
+            capacities = {16u << 10, 64u << 10, 256u << 10, 1u << 20};
+        } else if (strcmp(argv[arg], "-m") == 0 && arg + 1 < argc) {
+            cfg.mode = argv[++arg];
+        } else if (strcmp(argv[arg], "-z") == 0) {
+            cfg.zero_copy = true;
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (arg + 1 != argc || sizes.empty() || capacities.empty() ||
+        (cfg.mode != "single" && cfg.mode != "process" && cfg.mode != "thread"))
+        usage(argv[0]);
+
+    duration = parse_duration(argv[arg]);
+    if (duration <= 0) {
+        std::cerr << "Invalid duration: " << argv[arg] << std::endl;
+        exit(1);
+    }
+    if (cfg.zero_copy) {
+        cfg.devnull = open("/dev/null", O_WRONLY | O_CLOEXEC);
+        if (cfg.devnull < 0) {
+            std::cerr << "cannot open /dev/null, error " << errno << std::endl;
+            exit(1);
+        }
+    }
+    signal(SIGPIPE, SIG_IGN);   // the producer learns about the closed pipe from EPIPE
+    if (cfg.mode != "single")
+        process_counters().open(); // before fork()/the producer thread, so both sides are counted
+
+    size_t points = sizes.size() * capacities.size();
+    double slice = points > 1 ? max(duration / static_cast<double>(points), 0.05) : duration;
+    if (points > 1) {
+        printf("pipe: mode %s, %s, %.3f s per point\n", cfg.mode.c_str(), cfg.zero_copy ? "vmsplice/splice" : "write/read", slice);
+        printf("%10s %10s %14s %10s\n", "message", "pipe", "msgs/s", "GB/s");
+    }
+
+    BenchResult result(bench_name(argv[0]), 0, 0);
+    result.tag("mode", cfg.mode);
+    result.tag("io", cfg.zero_copy ? "splice" : "copy");
+    double best_gbps = -1;
+    bool first = true;
+
+    for (size_t cap : capacities) {
+        for (size_t size : sizes) {
+            BenchResult r(bench_name(argv[0]), 0, 0);
+            Point pt = run_point(cfg, size, cap, slice, first, points > 1 ? r : result);
+            first = false;
+            double secs = static_cast<double>(pt.ns) / 1e9;
+            double gbps = static_cast<double>(pt.bytes) / secs / 1e9;
+
+            if (points == 1) {
+                result.count = static_cast<double>(pt.messages);
+                result.iterations = pt.messages;
+                result.elapsed_ns = pt.ns;
+                result.add("message_bytes", static_cast<double>(size), "throughput");
+                result.add("pipe_bytes", pt.pipe_bytes, "throughput");
+                result.add("gbps", gbps, "throughput");
+                continue;
+            }
+
+            printf("%10s %10s %14.0f %10.3f\n", size_label(size).c_str(), size_label(static_cast<size_t>(pt.pipe_bytes)).c_str(),
+                   static_cast<double>(pt.messages) / secs, gbps);
+            r.count = static_cast<double>(pt.messages);
+            r.iterations = pt.messages;
+            r.elapsed_ns = pt.ns;
+            r.tag("mode", cfg.mode);
+            r.tag("io", cfg.zero_copy ? "splice" : "copy");
+            r.add("message_bytes", static_cast<double>(size), "point");
+            r.add("pipe_bytes", pt.pipe_bytes, "point");
+            r.add("gbps", gbps, "point");
+            emit_json(r);
+
+            result.add("m" + size_label(size) + "_p" + size_label(static_cast<size_t>(pt.pipe_bytes)), gbps, "gbps");
+            if (gbps > best_gbps) {
+                best_gbps = gbps;
+                result.count = gbps * 1000;
+                result.iterations = pt.messages;
+                result.elapsed_ns = pt.ns;
+            }
+        }
+    }
+
+    if (points > 1) {
+        fflush(stdout);
+        result.unit = "MBps";
+    }
+    emit_result(result);
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,166 @@
+/**
+ * @file        result.cpp
+ * @brief       Common result emitter (COUNT| lines plus JSON lines)
+ * @author      rRNA
+ * @version     4.0.0
+ * @date        10-17-2026
+ *
+ * @details
+ * Output is assembled in a single buffer and written with one write(2) so
+ * lines from concurrent copies sharing a pipe do not interleave.
+ */
+
+#include "result.hpp"
+#include "perfcount.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <sched.h>
+#include <unistd.h>
+
+BenchResult::BenchResult(std::string name, unsigned long count, uint64_t elapsed_ns,
+                         const char* unit, int timebase)
+    : name(std::move(name)), unit(unit), count(static_cast<double>(count)),
+      timebase(timebase), elapsed_ns(elapsed_ns), iterations(count) {}
+
+void BenchResult::add(const std::string& key, double value, const std::string& group) {
+    for (auto& g : groups) {
+        if (g.first == group) {
+            g.second.emplace_back(key, value);
+            return;
+        }
+    }
+    groups.push_back({group, {{key, value}}});
+}
+
+void BenchResult::tag(const std::string& key, const std::string& value) {
+    tags.emplace_back(key, value);
+}
+
+std::string bench_name(const char* argv0) {
+    if (argv0 == nullptr)
+        return "unknown";
+    const char* slash = std::strrchr(argv0, '/');
+    return slash ? slash + 1 : argv0;
+}
+
+static void write_all(const std::string& out) {
+    size_t done = 0;
+    while (done < out.size()) {
+        ssize_t n = write(STDERR_FILENO, out.data() + done, out.size() - done);
+        if (n <= 0)
+            return;
+        done += static_cast<size_t>(n);
+    }
+}
+
+static void append_number(std::string& out, double v) {
+    char buf[64];
+    if (!std::isfinite(v))
+        std::snprintf(buf, sizeof(buf), "null");
+    else if (v == std::floor(v) && std::fabs(v) < 1e15)
+        std::snprintf(buf, sizeof(buf), "%.0f", v);
+    else
+        std::snprintf(buf, sizeof(buf), "%.10g", v);
+    out += buf;
+}
+
+static void append_string(std::string& out, const std::string& s) {
+    out += '"';
+    for (char c : s) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char esc[8];
+                    std::snprintf(esc, sizeof(esc), "\\u%04x", c);
+                    out += esc;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    out += '"';
+}
+
+static std::string format_count(const BenchResult& r) {
+    char buf[128];
+    std::string out;
+    if (r.count == std::floor(r.count))
+        std::snprintf(buf, sizeof(buf), "COUNT|%.0f|%d|%s\n", r.count, r.timebase, r.unit.c_str());
+    else
+        std::snprintf(buf, sizeof(buf), "COUNT|%.3f|%d|%s\n", r.count, r.timebase, r.unit.c_str());
+    out += buf;
+    if (r.elapsed_ns) {
+        std::snprintf(buf, sizeof(buf), "TIME|%.9f\n", static_cast<double>(r.elapsed_ns) / 1e9);
+        out += buf;
+    }
+    return out;
+}
+
+static std::string format_json(const BenchResult& r) {
+    std::string out = "{\"name\":";
+    append_string(out, r.name);
+    out += ",\"unit\":";
+    append_string(out, r.unit);
+    out += ",\"count\":";
+    append_number(out, r.count);
+    out += ",\"timebase\":" + std::to_string(r.timebase);
+    out += ",\"elapsed_ns\":" + std::to_string(r.elapsed_ns);
+    out += ",\"iterations\":" + std::to_string(r.iterations);
+    out += ",\"cpu\":" + std::to_string(r.cpu >= 0 ? r.cpu : sched_getcpu());
+    out += ",\"pid\":" + std::to_string(getpid());
+    for (const auto& t : r.tags) {
+        out += ',';
+        append_string(out, t.first);
+        out += ':';
+        append_string(out, t.second);
+    }
+    for (const auto& g : r.groups) {
+        out += ',';
+        append_string(out, g.first);
+        out += ":{";
+        bool first = true;
+        for (const auto& kv : g.second) {
+            if (!first)
+                out += ',';
+            first = false;
+            append_string(out, kv.first);
+            out += ':';
+            append_number(out, kv.second);
+        }
+        out += '}';
+    }
+    out += "}\n";
+    return out;
+}
+
+void emit_count(const BenchResult& r) {
+    write_all(format_count(r));
+}
+
+// Results measured with BenchTimer carry the process counters when UB_PERF is set
+static std::string format_json_with_counters(const BenchResult& r) {
+    PerfCounters& counters = process_counters();
+    if (!counters.attempted() || !counters.requested())
+        return format_json(r);
+    for (const auto& g : r.groups) {
+        if (g.first == "perf")
+            return format_json(r);
+    }
+    BenchResult out = r;
+    counters.report(out);
+    return format_json(out);
+}
+
+void emit_json(const BenchResult& r) {
+    write_all(format_json_with_counters(r));
+}
+
+void emit_result(const BenchResult& r) {
+    write_all(format_count(r) + format_json_with_counters(r));
+}
@@ -0,0 +1,59 @@
+/**
+ * @file        result.hpp
+ * @brief       Common result emitter (COUNT| lines plus JSON lines)
+ * @author      rRNA
+ * @version     4.0.0
+ * @date        10-17-2026
+ *
+ * @details
+ * Every benchmark reports through emit_result(). It writes the classic
+ * COUNT|score|timebase|label and TIME|seconds lines that Run.py and the
+ * original Perl harness understand, followed by one JSON object per result:
+ *
+ *   {"name":"pipe","unit":"lps","count":123,"timebase":1,"elapsed_ns":...,
+ *    "iterations":123,"cpu":3,"pid":4711,"metrics":{...}}
+ *
+ * Sub-metrics (whetstone sections, fstime phases, latency percentiles, ...)
+ * are grouped into named JSON objects.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct BenchResult {
+    std::string name;
+    std::string unit = "lps";
+    double count = 0;           // The score as printed on the COUNT line
+    int timebase = 1;
+    uint64_t elapsed_ns = 0;
+    uint64_t iterations = 0;
+    int cpu = -1;               // CPU the result was measured on, -1 means the calling thread's
+
+    // String annotations (test mode, detected features, ...), emitted at top level
+    std::vector<std::pair<std::string, std::string>> tags;
+    // Named groups of numeric sub-metrics, emitted as nested objects
+    std::vector<std::pair<std::string, std::vector<std::pair<std::string, double>>>> groups;
+
+    BenchResult() = default;
+    BenchResult(std::string name, unsigned long count, uint64_t elapsed_ns,
+                const char* unit = "lps", int timebase = 1);
+
+    void add(const std::string& key, double value, const std::string& group = "metrics");
+    void tag(const std::string& key, const std::string& value);
+};
+
+// Benchmark name from argv[0] (basename), so each arith variant reports its own name
+std::string bench_name(const char* argv0);
+
+// COUNT| and TIME| lines on stderr
+void emit_count(const BenchResult& r);
+
+// One JSON object on a single line on stderr
+void emit_json(const BenchResult& r);
+
+// Both of the above
+void emit_result(const BenchResult& r);
@@ -9,62 +9,456 @@
  * This file is a C++ rewrite of spawn.c from the original UnixBench project.
  * Original project address: https://github.com/kdlucas/byte-unixbench/tree/v5.1.3
  *
+ * Without options this is the original test: fork(), the child _exit()s, the
+ * parent wait()s. Options select how the child is created and how big the
+ * parent is:
  *
+ *   -m mode    fork (default), vfork, posix_spawn, clone (CLONE_VM|CLONE_VFORK)
+ *              or clone3 (fork-like, with CLONE_PIDFD, reaped via the pidfd)
+ *   -e         the child execs /bin/true instead of exiting (posix_spawn
+ *              always does, so use -e to compare it with the others)
+ *   -r sizes   parent RSS: anonymous memory touched before the timed loop,
+ *              comma separated with K/M/G suffixes
+ *   -R         RSS sweep 1M, 8M, 64M, 512M, 1G, 4G, 8G (sizes that do not fit
+ *              in half of MemAvailable are skipped)
+ *   -t thp     on (MADV_HUGEPAGE), off (MADV_NOHUGEPAGE), both, or default
+ *              (no advice); -R without -t measures both
+ *   -T threads fork storm: 1, 2, 4 .. threads of this one process spawn
+ *              concurrently (pinned with -p compact|scatter|core), with the
+ *              largest -r size as parent memory and the first -t mode
  *
+ * The storm shows what independent copies cannot: every fork() of a threaded
+ * parent takes its mmap_lock for writing and copies one shared set of page
+ * tables, so threads of one process contend where separate processes do not.
+ * Each thread count reports spawns/s and the scaling efficiency
+ * X(t) / (t * X(1)); the knee is the last count still above 70%. With -e this
+ * is the exec storm of a launcher (fork+exec of /bin/true per child).
+ *
+ * fork() copies the parent's page tables, so its cost grows with RSS, and 2 MiB
+ * pages make that table 512 times smaller; vfork/clone(CLONE_VM) share the
+ * address space and should stay flat. With a single point the COUNT| line is
+ * unchanged; a sweep reports every point as a JSON line, and COUNT| is the
+ * rate at the largest RSS.
  */
 
 #include <iostream>
 #include <cstdlib>
 #include <cerrno>
+#include <cstring>
+#include <atomic>
+#include <string>
+#include <vector>
 #include <unistd.h>
 #include <cstdio>
-#include "timeit.cpp" // The wake_me function is defined in timeit.cpp
+#include <sched.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/sched.h>    // struct clone_args
+#include "timeit.hpp" // BenchTimer lives in the ubcommon library
+#include "result.hpp"
+#include "histogram.hpp"
+#include "topology.hpp"
+#include "workpool.hpp"
 
 #include <sys/wait.h>
 using namespace std;
 
+extern char** environ;
+
 // Global iteration count variable
 volatile unsigned long iter = 0;
 
-// The callback function called when the timer is triggered
-void report(int sig) {
-    char buf[64];
-    int len = snprintf(buf, sizeof(buf), "COUNT|%lu|1|lps\n", iter);
-    write(STDERR_FILENO, buf, len);
-    _exit(0);  // Avoiding C++ exit cleanup
+constexpr size_t HUGE_PAGE = 2u << 20;
+
+struct Options {
+    string mode = "fork";
+    bool exec = false;
+};
+
+static const char* const TRUE_PATH = "/bin/true";
+static char* const true_argv[] = {const_cast<char*>(TRUE_PATH), nullptr};
+
+[[noreturn]] static void child_body(bool exec) {
+    if (exec) {
+        execve(TRUE_PATH, true_argv, environ);
+        _exit(127);
+    }
+    _exit(0); // child, skip the parent's atexit/stdio cleanup
 }
 
-int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " duration" << std::endl;
-        exit(1);
+static int clone_child(void* arg) {
+    child_body(*static_cast<bool*>(arg));
+}
+
+alignas(64) static thread_local char clone_stack[64 << 10];   // one per storm thread
+
+// Create one child and reap it; false if creation failed, status gets the wait status
+static bool spawn_one(const Options& o, int& status) {
+    pid_t pid;
+    if (o.mode == "fork") {
+        pid = fork();
+        if (pid == 0)
+            child_body(o.exec);
+    } else if (o.mode == "vfork") {
+        pid = vfork();
+        if (pid == 0)
+            child_body(o.exec);
+    } else if (o.mode == "posix_spawn") {
+        int err = posix_spawn(&pid, TRUE_PATH, nullptr, nullptr, true_argv, environ);
+        if (err != 0) {
+            errno = err;
+            pid = -1;
+        }
+    } else if (o.mode == "clone") {
+        bool exec = o.exec;
+        pid = clone(clone_child, clone_stack + sizeof(clone_stack), CLONE_VM | CLONE_VFORK | SIGCHLD, &exec);
+    } else {
+        int pidfd = -1;
+        struct clone_args args;
+        memset(&args, 0, sizeof(args));
+        args.flags = CLONE_PIDFD;
+        args.pidfd = reinterpret_cast<uintptr_t>(&pidfd);
+        args.exit_signal = SIGCHLD;
+        pid = static_cast<pid_t>(syscall(SYS_clone3, &args, sizeof(args)));
+        if (pid == 0)
+            child_body(o.exec);
+        if (pid < 0)
+            return false;
+        siginfo_t info;
+        memset(&info, 0, sizeof(info));
+        while (waitid(P_PIDFD, static_cast<id_t>(pidfd), &info, WEXITED) < 0 && errno == EINTR) {
+        }
+        close(pidfd);
+        status = (info.si_code == CLD_EXITED) ? (info.si_status << 8) : 1;
+        return true;
+    }
+    if (pid < 0)
+        return false;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+    }
+    return true;
+}
+
+// Parse "1M,512M,4G" into bytes; empty on a malformed entry
+static vector<size_t> parse_sizes(const char* text) {
+    vector<size_t> out;
+    const char* p = text;
+    while (*p) {
+        char* end = nullptr;
+        unsigned long long v = strtoull(p, &end, 10);
+        if (end == p)
+            return {};
+        if (*end == 'K' || *end == 'k')
+            v <<= 10, ++end;
+        else if (*end == 'M' || *end == 'm')
+            v <<= 20, ++end;
+        else if (*end == 'G' || *end == 'g')
+            v <<= 30, ++end;
+        if (*end != ',' && *end != '\0')
+            return {};
+        out.push_back(static_cast<size_t>(v));
+        p = (*end == ',') ? end + 1 : end;
     }
+    return out;
+}
+
+static string size_label(size_t bytes) {
+    char buf[32];
+    if (bytes >= (1u << 30) && bytes % (1u << 30) == 0)
+        snprintf(buf, sizeof(buf), "%zuG", bytes >> 30);
+    else if (bytes >= (1u << 20) && bytes % (1u << 20) == 0)
+        snprintf(buf, sizeof(buf), "%zuM", bytes >> 20);
+    else
+        snprintf(buf, sizeof(buf), "%zuK", bytes >> 10);
+    return buf;
+}
 
-    int duration = std::atoi(argv[1]);
-    if (duration < 1) {
-        std::cerr << "Invalid duration: " << argv[1] << std::endl;
+// Value of one "Key:   123 kB" line of a /proc file, in bytes (0 if missing)
+static size_t proc_kb(const char* path, const char* key) {
+    FILE* f = fopen(path, "r");
+    if (f == nullptr)
+        return 0;
+    char line[256];
+    size_t len = strlen(key), kb = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, key, len) == 0 && line[len] == ':') {
+            kb = strtoull(line + len + 1, nullptr, 10);
+            break;
+        }
+    }
+    fclose(f);
+    return kb << 10;
+}
+
+// Anonymous memory of the parent, touched so it is resident, with the THP advice applied
+struct Ballast {
+    void* map = nullptr;
+    size_t len = 0;
+};
+
+static Ballast make_ballast(size_t bytes, const string& thp) {
+    Ballast b;
+    if (bytes == 0)
+        return b;
+    b.len = (bytes + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1);
+    b.map = mmap(nullptr, b.len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (b.map == MAP_FAILED) {
+        std::cerr << "cannot map " << size_label(bytes) << " of parent memory" << std::endl;
         exit(1);
     }
+    if (thp == "on")
+        madvise(b.map, b.len, MADV_HUGEPAGE);
+    else if (thp == "off")
+        madvise(b.map, b.len, MADV_NOHUGEPAGE);
+    memset(b.map, 1, b.len);
+    return b;
+}
 
-    wake_me(duration, report);
-    iter = 0;
+// ------------------------------------------------------------- fork storm ----
+struct alignas(64) StormSlot {
+    unsigned long spawns = 0;
+    bool failed = false;
+};
 
+// One point of the storm: spawn until the window closes
+static void storm_run(const Options* o, const BenchTimer* timer, StormSlot* slot) {
     int status = 0;
-    while (true) {
-        pid_t pid = fork();
-        if (pid == 0) {
-            exit(0); // child
-        } else if (pid < 0) {
-            std::cerr << "Fork failed at iteration " << iter << std::endl;
-            perror("Reason");
-            exit(2);
+    while (!timer->expired()) {
+        if (!spawn_one(*o, status) || status != 0) {
+            slot->failed = true;
+            break;
+        }
+        ++slot->spawns;
+    }
+}
+
+static int run_storm(const Options& o, int max_threads, const string& policy, size_t bytes,
+                     const string& thp, double duration, const char* prog) {
+    vector<int> counts;
+    for (int t = 1; t < max_threads; t *= 2)
+        counts.push_back(t);
+    counts.push_back(max_threads);
+    vector<int> cpus = place_cpus(policy, max_threads);
+    if (cpus.empty()) {
+        std::cerr << "Unknown placement policy: " << policy << std::endl;
+        return 1;
+    }
+    double slice = max(duration / static_cast<double>(counts.size()), 0.2);
+
+    Ballast ballast = make_ballast(bytes, thp);
+    BenchTimer timer;
+    vector<StormSlot> slots(max_threads);
+    WorkerPool pool;
+    pool.start(cpus, [&](int tid) { storm_run(&o, &timer, &slots[tid]); });
+
+    BenchResult result(bench_name(prog), 0, 0);
+    result.tag("mode", o.mode);
+    result.tag("child", o.exec ? "exec" : "exit");
+    result.tag("thp", thp);
+    result.tag("placement", policy);
+    double base = 0, peak = 0;
+    int knee = 0, peak_threads = 0;
+    bool first = true, failed = false;
+
+    for (int n : counts) {
+        for (auto& s : slots)
+            s = StormSlot();
+        timer.start(slice, first);
+        first = false;
+        pool.release(n);
+        pool.wait();
+        uint64_t ns = timer.stop();     // after the last counted child was reaped
+
+        unsigned long total = 0;
+        for (int i = 0; i < n; ++i) {
+            total += slots[i].spawns;
+            failed |= slots[i].failed;
+        }
+        double rate = static_cast<double>(total) / (static_cast<double>(ns) / 1e9);
+        if (n == 1)
+            base = rate;
+        double efficiency = base > 0 ? rate / (base * n) : 0;
+        if (efficiency >= 0.7)
+            knee = n;
+
+        BenchResult r(bench_name(prog), total, ns);
+        r.tag("mode", o.mode);
+        r.tag("child", o.exec ? "exec" : "exit");
+        r.tag("thp", thp);
+        r.add("threads", n, "storm");
+        r.add("spawns_per_sec", rate, "storm");
+        r.add("efficiency", efficiency, "storm");
+        emit_json(r);
+
+        result.add("t" + std::to_string(n), rate, "spawns_per_sec");
+        result.add("t" + std::to_string(n), efficiency, "efficiency");
+        if (rate > peak) {
+            peak = rate;
+            peak_threads = n;
+            result.count = static_cast<double>(total);
+            result.iterations = total;
+            result.elapsed_ns = ns;
+        }
+    }
+
+    pool.stop();
+    if (ballast.map)
+        munmap(ballast.map, ballast.len);
+    if (failed) {
+        std::cerr << o.mode << " failed during the storm" << std::endl;
+        return 2;
+    }
+
+    result.add("ballast_bytes", static_cast<double>(bytes), "config");
+    result.add("max_threads", max_threads, "config");
+    result.add("peak_threads", peak_threads, "config");
+    result.add("knee_threads", knee, "config");
+    emit_result(result);
+    return 0;
+}
+
+static void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [-m fork|vfork|posix_spawn|clone|clone3] [-e] [-r sizes | -R]"
+              << " [-t on|off|both|default] [-T threads [-p policy]] duration" << std::endl;
+    exit(1);
+}
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    vector<size_t> sizes = {0};
+    string thp;
+    int storm_threads = 0;
+    string policy = "compact";
+
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; ++arg) {
+        if (strcmp(argv[arg], "-m") == 0 && arg + 1 < argc) {
+            opt.mode = argv[++arg];
+        } else if (strcmp(argv[arg], "-e") == 0) {
+            opt.exec = true;
+        } else if (strcmp(argv[arg], "-r") == 0 && arg + 1 < argc) {
+            sizes = parse_sizes(argv[++arg]);
+        } else if (strcmp(argv[arg], "-R") == 0) {
+            sizes = {1u << 20, 8u << 20, 64u << 20, 512u << 20, size_t(1) << 30, size_t(4) << 30, size_t(8) << 30};
+            if (thp.empty())
+                thp = "both";
+        } else if (strcmp(argv[arg], "-t") == 0 && arg + 1 < argc) {
+            thp = argv[++arg];
+        } else if (strcmp(argv[arg], "-T") == 0 && arg + 1 < argc) {
+            storm_threads = atoi(argv[++arg]);
+            if (storm_threads < 1)
+                usage(argv[0]);
+        } else if (strcmp(argv[arg], "-p") == 0 && arg + 1 < argc) {
+            policy = argv[++arg];
         } else {
-            wait(&status);
-            if (status != 0) {
-                std::cerr << "Bad wait status: 0x" << std::hex << status << std::endl;
-                exit(2);
+            usage(argv[0]);
+        }
+    }
+    if (thp.empty())
+        thp = "default";
+    if (arg + 1 != argc || sizes.empty() ||
+        (opt.mode != "fork" && opt.mode != "vfork" && opt.mode != "posix_spawn" &&
+         opt.mode != "clone" && opt.mode != "clone3") ||
+        (thp != "on" && thp != "off" && thp != "both" && thp != "default"))
+        usage(argv[0]);
+    if (opt.mode == "posix_spawn")
+        opt.exec = true;
+
+    double duration = parse_duration(argv[arg]);
+    if (duration <= 0) {
+        std::cerr << "Invalid duration: " << argv[arg] << std::endl;
+        exit(1);
+    }
+
+    // Drop sizes that would push the machine into reclaim or swap
+    size_t avail = proc_kb("/proc/meminfo", "MemAvailable");
+    vector<size_t> fit;
+    for (size_t s : sizes) {
+        if (avail == 0 || s <= avail / 2)
+            fit.push_back(s);
+        else
+            std::cerr << "spawn: skipping " << size_label(s) << " parent RSS, MemAvailable is " << size_label(avail) << std::endl;
+    }
+    if (fit.empty())
+        exit(1);
+    vector<string> thp_modes;
+    if (thp == "both") {
+        thp_modes = {"off", "on"};
+    } else {
+        thp_modes = {thp};
+    }
+    if (storm_threads)
+        return run_storm(opt, storm_threads, policy, fit.back(), thp_modes.front(), duration, argv[0]);
+
+    size_t points = fit.size() * thp_modes.size();
+    double slice = points > 1 ? max(duration / static_cast<double>(points), 0.1) : duration;
+    BenchResult result(bench_name(argv[0]), 0, 0);
+    result.tag("mode", opt.mode);
+    result.tag("child", opt.exec ? "exec" : "exit");
+    string score_thp;
+    bool first = true;
+
+    for (const string& t : thp_modes) {
+        for (size_t bytes : fit) {
+            Ballast ballast = make_ballast(bytes, t);
+            size_t rss = proc_kb("/proc/self/smaps_rollup", "Rss");
+            size_t huge = proc_kb("/proc/self/smaps_rollup", "AnonHugePages");
+
+            LatencyRecorder lat;    // fork() to reaped child, every Nth iteration
+            BenchTimer timer;
+            timer.start(slice, first);
+            first = false;
+            iter = 0;
+
+            int status = 0;
+            while (!timer.expired()) {
+                lat.begin();
+                if (!spawn_one(opt, status)) {
+                    std::cerr << opt.mode << " failed at iteration " << iter << std::endl;
+                    perror("Reason");
+                    exit(2);
+                }
+                lat.end();
+                if (status != 0) {
+                    std::cerr << "Bad wait status: 0x" << std::hex << status << std::endl;
+                    exit(2);
+                }
+                iter++;
+            }
+            uint64_t ns = timer.stop();
+            if (ballast.map)
+                munmap(ballast.map, ballast.len);
+
+            double us = iter ? static_cast<double>(ns) / 1e3 / static_cast<double>(iter) : 0;
+            BenchResult r(bench_name(argv[0]), iter, ns);
+            r.tag("mode", opt.mode);
+            r.tag("child", opt.exec ? "exec" : "exit");
+            if (bytes || t != "default") {
+                r.tag("thp", t);
+                r.add("ballast_bytes", static_cast<double>(bytes), "parent");
+                r.add("rss_bytes", static_cast<double>(rss), "parent");
+                r.add("anon_huge_bytes", static_cast<double>(huge), "parent");
+                r.add("us_per_spawn", us, "parent");
+            }
+            lat.report(r);
+            if (points == 1) {
+                emit_result(r);
+                return 0;
+            }
+            emit_json(r);
+            result.add(t + "_" + size_label(bytes) + "_us", us, "rss_sweep");
+            if (bytes == fit.back()) {
+                result.count = static_cast<double>(iter);
+                result.iterations = iter;
+                result.elapsed_ns = ns;
+                score_thp = t;
             }
-            iter++;
         }
     }
+
+    result.tag("thp", score_thp);
+    emit_result(result);
+    return 0;
 }
@@ -0,0 +1,413 @@
+/**
+ * @file        syncbench.cpp
+ * @brief       Lock and atomic contention benchmark (mutex, spinlocks, futex, atomics)
+ * @author      rRNA
+ * @version     4.0.0
+ * @date        10-17-2026
+ *
+ * @details
+ * syscall and context1 measure the cost of entering the kernel and of switching
+ * processes; this test measures synchronization inside one process. Each
+ * primitive is run on 1..N pinned threads (powers of two plus N) and reported
+ * as total operations per second and nanoseconds per operation per thread:
+ *
+ *   mutex          one std::mutex shared by all threads (uncontended at 1 thread)
+ *   mutex_private  one std::mutex per thread, never contended
+ *   ticket         ticket spinlock
+ *   mcs            MCS queue lock (each waiter spins on its own line)
+ *   futex          token passed around a ring of threads with FUTEX_WAIT/WAKE
+ *   atomic_shared  fetch_add on one shared cache line
+ *   atomic_padded  fetch_add on per-thread counters, one cache line each
+ *   cas            compare-and-swap increment loop on one shared line
+ *   rwlock_read    std::shared_mutex lock_shared/unlock_shared
+ *
+ * The lock tests increment a plain counter inside the critical section and
+ * check it afterwards, so a broken lock is reported rather than timed.
+ *
+ * Usage:
+ *   syncbench [-t max_threads] [-p policy] [-b benches] duration
+ */
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "timeit.hpp"
+#include "result.hpp"
+#include "topology.hpp"
+#include "workpool.hpp"
+
+using namespace std;
+
+constexpr int MAX_THREADS = 1024;
+
+// ------------------------------------------------------------ primitives ----
+class TicketLock {
+public:
+    void lock() {
+        unsigned ticket = next.fetch_add(1, std::memory_order_relaxed);
+        while (serving.load(std::memory_order_acquire) != ticket)
+            cpu_relax();
+    }
+    void unlock() {
+        serving.store(serving.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+private:
+    alignas(64) std::atomic<unsigned> next{0};
+    alignas(64) std::atomic<unsigned> serving{0};
+};
+
+struct alignas(64) McsNode {
+    std::atomic<McsNode*> next{nullptr};
+    std::atomic<bool> locked{false};
+};
+
+class McsLock {
+public:
+    void lock(McsNode* node) {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        node->locked.store(true, std::memory_order_relaxed);
+        McsNode* prev = tail.exchange(node, std::memory_order_acq_rel);
+        if (prev != nullptr) {
+            prev->next.store(node, std::memory_order_release);
+            while (node->locked.load(std::memory_order_acquire))
+                cpu_relax();
+        }
+    }
+    void unlock(McsNode* node) {
+        McsNode* succ = node->next.load(std::memory_order_acquire);
+        if (succ == nullptr) {
+            McsNode* expected = node;
+            if (tail.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel))
+                return;
+            while ((succ = node->next.load(std::memory_order_acquire)) == nullptr)
+                cpu_relax();
+        }
+        succ->locked.store(false, std::memory_order_release);
+    }
+
+private:
+    alignas(64) std::atomic<McsNode*> tail{nullptr};
+};
+
+struct alignas(64) PaddedMutex {
+    std::mutex m;
+};
+
+struct alignas(64) PaddedCounter {
+    std::atomic<unsigned long> v{0};
+};
+
+struct alignas(64) FutexWord {
+    std::atomic<int> turn{0};
+};
+
+static long futex(std::atomic<int>* addr, int op, int val) {
+    return syscall(SYS_futex, reinterpret_cast<int*>(addr), op, val, nullptr, nullptr, 0);
+}
+
+// Shared state of the current point
+static std::mutex shared_mutex_;
+static PaddedMutex private_mutex[MAX_THREADS];
+static TicketLock ticket_lock;
+static McsLock mcs_lock;
+static McsNode mcs_node[MAX_THREADS];
+static std::shared_mutex rw_lock;
+alignas(64) static std::atomic<unsigned long> shared_counter{0};
+static PaddedCounter padded_counter[MAX_THREADS];
+static FutexWord futex_ring[MAX_THREADS];
+alignas(64) static unsigned long protected_count = 0;   // only touched under the lock being tested
+
+static std::atomic<bool> stop{false};
+static int nthreads = 1;
+
+// ---------------------------------------------------------------- benches ----
+static unsigned long run_mutex(int, const std::atomic<bool>& stop) {
+    unsigned long ops = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+        shared_mutex_.lock();
+        ++protected_count;
+        shared_mutex_.unlock();
+        ++ops;
+    }
+    return ops;
+}
+
+static unsigned long run_mutex_private(int tid, const std::atomic<bool>& stop) {
+    unsigned long ops = 0;
+    std::mutex& m = private_mutex[tid].m;
+    while (!stop.load(std::memory_order_relaxed)) {
+        m.lock();
+        m.unlock();
+        ++ops;
+    }
+    return ops;
+}
+
+static unsigned long run_ticket(int, const std::atomic<bool>& stop) {
+    unsigned long ops = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+        ticket_lock.lock();
+        ++protected_count;
+        ticket_lock.unlock();
+        ++ops;
+    }
+    return ops;
+}
+
+static unsigned long run_mcs(int tid, const std::atomic<bool>& stop) {
+    unsigned long ops = 0;
+    McsNode* node = &mcs_node[tid];
+    while (!stop.load(std::memory_order_relaxed)) {
+        mcs_lock.lock(node);
+        ++protected_count;
+        mcs_lock.unlock(node);
+        ++ops;
+    }
+    return ops;
+}
+
+static unsigned long run_futex(int tid, const std::atomic<bool>& stop) {
+    unsigned long ops = 0;
+    std::atomic<int>* mine = &futex_ring[tid].turn;
+    std::atomic<int>* next = &futex_ring[(tid + 1) % nthreads].turn;
+    while (!stop.load(std::memory_order_relaxed)) {
+        while (mine->load(std::memory_order_acquire) == 0) {
+            futex(mine, FUTEX_WAIT_PRIVATE, 0);
+            if (stop.load(std::memory_order_relaxed))
+                return ops;
+        }
+        mine->store(0, std::memory_order_relaxed);
+        ++ops;
+        next->store(1, std::memory_order_release);
+        futex(next, FUTEX_WAKE_PRIVATE, 1);
+    }
+    return ops;
+}
+
+static unsigned long run_atomic_shared(int, const std::atomic<bool>& stop) {
+    unsigned long ops = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+        shared_counter.fetch_add(1, std::memory_order_relaxed);
+        ++ops;
+    }
+    return ops;
+}
+
+static unsigned long run_atomic_padded(int tid, const std::atomic<bool>& stop) {
+    unsigned long ops = 0;
+    std::atomic<unsigned long>& c = padded_counter[tid].v;
+    while (!stop.load(std::memory_order_relaxed)) {
+        c.fetch_add(1, std::memory_order_relaxed);
+        ++ops;
+    }
+    return ops;
+}
+
+static unsigned long run_cas(int, const std::atomic<bool>& stop) {
+    unsigned long ops = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+        unsigned long v = shared_counter.load(std::memory_order_relaxed);
+        while (!shared_counter.compare_exchange_weak(v, v + 1, std::memory_order_relaxed))
+            ;
+        ++ops;
+    }
+    return ops;
+}
+
+static unsigned long run_rwlock_read(int, const std::atomic<bool>& stop) {
+    unsigned long ops = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+        rw_lock.lock_shared();
+        rw_lock.unlock_shared();
+        ++ops;
+    }
+    return ops;
+}
+
+// Wake every thread parked in the futex ring once the window is over
+static void release_futex() {
+    for (int i = 0; i < nthreads; ++i) {
+        futex_ring[i].turn.store(1, std::memory_order_release);
+        futex(&futex_ring[i].turn, FUTEX_WAKE_PRIVATE, INT_MAX);
+    }
+}
+
+struct Bench {
+    const char* name;
+    unsigned long (*run)(int tid, const std::atomic<bool>& stop);
+    bool checked;               // protected_count must equal the total operations
+    void (*release)();          // unblock waiters after stop, if the bench can block
+};
+
+static const Bench benches[] = {
+    {"mutex",         run_mutex,         true,  nullptr},
+    {"mutex_private", run_mutex_private, false, nullptr},
+    {"ticket",        run_ticket,        true,  nullptr},
+    {"mcs",           run_mcs,           true,  nullptr},
+    {"futex",         run_futex,         false, release_futex},
+    {"atomic_shared", run_atomic_shared, false, nullptr},
+    {"atomic_padded", run_atomic_padded, false, nullptr},
+    {"cas",           run_cas,           false, nullptr},
+    {"rwlock_read",   run_rwlock_read,   false, nullptr},
+};
+
+// ---------------------------------------------------------------- driver ----
+struct alignas(64) Slot {
+    unsigned long ops = 0;
+};
+
+static const Bench* current = nullptr;
+static void usage(const char* prog) {
+    cerr << "Usage: " << prog << " [-t max_threads] [-p policy] [-b benches] duration" << endl;
+    cerr << "  -t max_threads  largest thread count of the 1, 2, 4, ... sweep (default: allowed CPUs)" << endl;
+    cerr << "  -p policy       placement: compact, scatter, core or node (default compact)" << endl;
+    cerr << "  -b benches      comma separated subset of:";
+    for (const auto& b : benches)
+        cerr << " " << b.name;
+    cerr << endl;
+    cerr << "duration is the total time in seconds, shared by all points" << endl;
+    exit(1);
+}
+
+int main(int argc, char* argv[]) {
+    int max_threads = static_cast<int>(allowed_cpus().size());
+    string policy = "compact";
+    string bench_list;
+
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; ++arg) {
+        if (strcmp(argv[arg], "-t") == 0 && arg + 1 < argc)
+            max_threads = atoi(argv[++arg]);
+        else if (strcmp(argv[arg], "-p") == 0 && arg + 1 < argc)
+            policy = argv[++arg];
+        else if (strcmp(argv[arg], "-b") == 0 && arg + 1 < argc)
+            bench_list = argv[++arg];
+        else
+            usage(argv[0]);
+    }
+    if (arg >= argc || max_threads < 1 || max_threads > MAX_THREADS)
+        usage(argv[0]);
+    double duration = parse_duration(argv[arg]);
+    if (duration <= 0) {
+        cerr << "Invalid duration: " << argv[arg] << endl;
+        exit(1);
+    }
+
+    vector<int> counts;
+    for (int t = 1; t < max_threads; t *= 2)
+        counts.push_back(t);
+    counts.push_back(max_threads);
+
+    vector<const Bench*> run_benches;
+    for (const auto& b : benches) {
+        if (in_list(bench_list, b.name))
+            run_benches.push_back(&b);
+    }
+    vector<int> cpus = place_cpus(policy, max_threads);
+    if (run_benches.empty() || cpus.empty())
+        usage(argv[0]);
+
+    double slice = max(duration / static_cast<double>(counts.size() * run_benches.size()), 0.05);
+
+    // One pool of max_threads workers; points with fewer threads leave the rest asleep,
+    // so the low-thread points really are uncontended
+    vector<Slot> slots(max_threads);
+    WorkerPool pool;
+    pool.start(vector<int>(cpus.begin(), cpus.begin() + max_threads),
+               [&](int tid) { slots[tid].ops = current->run(tid, stop); });
+
+    printf("syncbench: threads 1..%d, placement %s, %.3f s per point\n", max_threads, policy.c_str(), slice);
+    printf("%-14s %7s %16s %12s %10s\n", "bench", "threads", "ops/s", "ns/op", "fairness");
+
+    BenchResult result;
+    result.name = "syncbench";
+    result.unit = "ops";
+    result.tag("placement", policy);
+    bool first = true;
+    int failures = 0;
+
+    for (const Bench* b : run_benches) {
+        for (int n : counts) {
+            current = b;
+            nthreads = n;
+            protected_count = 0;
+            for (int i = 0; i < n; ++i)
+                futex_ring[i].turn.store(i == 0 ? 1 : 0, std::memory_order_relaxed);
+            for (auto& s : slots)
+                s.ops = 0;
+            stop.store(false, std::memory_order_relaxed);
+
+            uint64_t t0, t1;
+            if (first) {
+                start_gate(slice, t0, t1);
+                first = false;
+            } else {
+                t0 = now_ns();
+                t1 = t0 + static_cast<uint64_t>(slice * 1e9);
+            }
+            pool.release(n);
+            sleep_until(t1);
+            stop.store(true, std::memory_order_relaxed);
+            if (b->release)
+                b->release();
+            pool.wait();
+            uint64_t elapsed = now_ns() - t0;
+
+            unsigned long total = 0, lo = ULONG_MAX, hi = 0;
+            for (int i = 0; i < n; ++i) {
+                total += slots[i].ops;
+                lo = min(lo, slots[i].ops);
+                hi = max(hi, slots[i].ops);
+            }
+            if (b->checked && protected_count != total) {
+                cerr << "syncbench: " << b->name << " lost updates at " << n << " threads: "
+                     << protected_count << " != " << total << endl;
+                ++failures;
+            }
+            double secs = static_cast<double>(elapsed) / 1e9;
+            double ops_per_sec = static_cast<double>(total) / secs;
+            double ns_per_op = total ? static_cast<double>(elapsed) * n / static_cast<double>(total) : 0;
+            // Slowest thread relative to the fastest: 1 is perfectly fair
+            double fairness = hi ? static_cast<double>(lo) / static_cast<double>(hi) : 0;
+            printf("%-14s %7d %16.0f %12.2f %10.3f\n", b->name, n, ops_per_sec, ns_per_op, fairness);
+
+            BenchResult r("syncbench", total, elapsed, "ops");
+            r.count = ops_per_sec;
+            r.tag("bench", b->name);
+            r.add("threads", n, "point");
+            r.add("ns_per_op", ns_per_op, "point");
+            r.add("fairness", fairness, "point");
+            emit_json(r);
+
+            string key = string(b->name) + "_t" + to_string(n);
+            result.add(key, ops_per_sec, "ops_per_sec");
+            result.add(key, ns_per_op, "ns_per_op");
+            // Headline: the first bench at the largest thread count
+            if (b == run_benches.front() && n == max_threads) {
+                result.count = ops_per_sec;
+                result.iterations = total;
+                result.elapsed_ns = elapsed;
+                result.tag("bench", b->name);
+            }
+        }
+    }
+
+    pool.stop();
+    fflush(stdout);
+
+    result.add("max_threads", max_threads, "config");
+    emit_result(result);
+    return failures ? 2 : 0;
+}
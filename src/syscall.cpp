@@ -9,32 +9,67 @@
  * This file is a C++ rewrite of syscall.c from the original UnixBench project.
  * Original project address: https://github.com/kdlucas/byte-unixbench/tree/v5.1.3
  *
+ * The "uring" test submits the same kind of work through io_uring in batches
+ * of 1..256 SQEs, to show how much batching wins back from the per-syscall
+ * entry cost (KPTI, retpolines, ...):
  *
+ *   syscall duration uring [ nop|close|read|statx ] [ batch|sweep ] [ sqpoll ]
  *
+ *   nop     IORING_OP_NOP
+ *   close   IORING_OP_OPENAT of /dev/null, then IORING_OP_CLOSE of the new fds
+ *           (io_uring has no dup, so one op is an open/close pair in two rounds)
+ *   read    IORING_OP_READ of 64 bytes from /dev/zero
+ *   statx   IORING_OP_STATX of /dev/null
+ *
+ * sweep (the default) runs batch sizes 1, 2, 4 .. 256 and reports each as a
+ * JSON line; sqpoll lets a kernel thread pick up the SQEs so that, while it is
+ * awake, submission needs no system call at all. COUNT| is operations, not
+ * batches; the mean time from submitting a batch to reaping its last CQE is
+ * in the "uring" group, UB_LAT_SAMPLE adds its percentiles.
+ *
+ * "getpid" goes through glibc, which may serve it without trapping. These
+ * modes pin down what is actually being timed:
+ *
+ *   getpid-raw     syscall(SYS_getpid), always a real kernel entry
+ *   clock-vdso     clock_gettime(CLOCK_MONOTONIC), served by the vDSO
+ *   clock-syscall  syscall(SYS_clock_gettime, ...), the same call trapping
+ *   enosys         syscall(-1): entry, ENOSYS, exit, nothing else
+ *   breakdown      all of the above plus glibc getpid, each for a share of
+ *                  the duration, with the deltas between them
+ *
+ * enosys is the bare entry/exit cost, which is what the speculative-execution
+ * mitigations (KPTI, retpolines, IBRS, VERW, ...) inflate. The results of
+ * these call modes, breakdown and uring are tagged with the kernel release
+ * and the contents of /sys/devices/system/cpu/vulnerabilities, so a
+ * regression across kernel rollouts can be matched to the mitigation that
+ * changed; the classic tests (mix, getpid, exec, ...) stay untagged.
  */
 
 #include <iostream>
+#include <algorithm>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <string>
+#include <vector>
+#include <ctime>
+#include <dirent.h>
+#include <fcntl.h>
 #include <unistd.h>
+#include <sys/utsname.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <sys/syscall.h>
 
-// The timing tool implementation has been moved to timeit.cpp
-// to keep it consistent with the original version
-#include "timeit.cpp"
+// The timing core (BenchTimer) and result emitter live in the ubcommon library
+#include "timeit.hpp"
+#include "result.hpp"
+#include "histogram.hpp"
+#include "uring.hpp"
 
 static unsigned long iter = 0;
 
-// The report function needs to match the signature of wake_me:
-// it receives the remaining seconds parameter
-void report(int /*unused*/) {
-    std::cerr << "COUNT|" << iter << "|1|lps" << std::endl;
-    std::exit(0);
-}
-
 int create_fd() {
     int fd[2];
     if (pipe(fd) != 0 || close(fd[1]) != 0) {
@@ -43,53 +78,347 @@ int create_fd() {
     return fd[0];
 }
 
+// Tag r with the kernel release and one "vuln_<name>" per /sys/devices/system/cpu/vulnerabilities entry
+static void tag_mitigations(BenchResult& r) {
+    struct utsname u;
+    if (uname(&u) == 0)
+        r.tag("kernel", u.release);
+    const char* dir = "/sys/devices/system/cpu/vulnerabilities";
+    DIR* d = opendir(dir);
+    if (d == nullptr)
+        return;
+    std::vector<std::string> names;
+    while (struct dirent* e = readdir(d)) {
+        if (e->d_name[0] != '.')
+            names.push_back(e->d_name);
+    }
+    closedir(d);
+    std::sort(names.begin(), names.end());
+    for (const auto& name : names) {
+        FILE* f = std::fopen((std::string(dir) + "/" + name).c_str(), "r");
+        if (f == nullptr)
+            continue;
+        char line[512];
+        if (std::fgets(line, sizeof(line), f)) {
+            line[std::strcspn(line, "\n")] = '\0';
+            r.tag("vuln_" + name, line);
+        }
+        std::fclose(f);
+    }
+}
+
+static long call_getpid() { return getpid(); }
+static long call_getpid_raw() { return syscall(SYS_getpid); }
+static long call_clock_vdso() {
+    struct timespec ts;
+    return clock_gettime(CLOCK_MONOTONIC, &ts);
+}
+static long call_clock_syscall() {
+    struct timespec ts;
+    return syscall(SYS_clock_gettime, CLOCK_MONOTONIC, &ts);
+}
+static long call_enosys() { return syscall(-1); }
+
+struct CallMode {
+    const char* name;
+    long (*fn)();
+};
+
+static const CallMode call_modes[] = {
+    {"getpid",        call_getpid},
+    {"getpid-raw",    call_getpid_raw},
+    {"clock-vdso",    call_clock_vdso},
+    {"clock-syscall", call_clock_syscall},
+    {"enosys",        call_enosys},
+};
+
+static const CallMode* find_call_mode(const std::string& name) {
+    for (const auto& m : call_modes) {
+        if (name == m.name)
+            return &m;
+    }
+    return nullptr;
+}
+
+static BenchResult time_calls(const CallMode& m, double seconds, bool gated, const char* prog) {
+    unsigned long calls = 0;
+    LatencyRecorder lat;    // UB_LAT_SAMPLE=N times every Nth call
+    BenchTimer timer;
+    timer.start(seconds, gated);
+    while (!timer.expired()) {
+        lat.begin();
+        m.fn();
+        lat.end();
+        ++calls;
+    }
+    BenchResult r(bench_name(prog), calls, timer.stop());
+    r.tag("mode", m.name);
+    lat.report(r);
+    return r;
+}
+
+static double ns_per_call(const BenchResult& r) {
+    return r.iterations ? static_cast<double>(r.elapsed_ns) / static_cast<double>(r.iterations) : 0;
+}
+
+static int run_calls(const std::string& test, double duration, const char* prog) {
+    if (test != "breakdown") {
+        BenchResult r = time_calls(*find_call_mode(test), duration, true, prog);
+        r.add("ns_per_call", ns_per_call(r), "calls");
+        tag_mitigations(r);
+        emit_result(r);
+        return EXIT_SUCCESS;
+    }
+
+    double slice = duration / static_cast<double>(sizeof(call_modes) / sizeof(call_modes[0]));
+    BenchResult result(bench_name(prog), 0, 0);
+    result.tag("mode", "breakdown");
+    tag_mitigations(result);
+    double ns[sizeof(call_modes) / sizeof(call_modes[0])];
+    bool first = true;
+    size_t i = 0;
+    for (const auto& m : call_modes) {
+        BenchResult r = time_calls(m, slice, first, prog);
+        first = false;
+        ns[i++] = ns_per_call(r);
+        r.add("ns_per_call", ns_per_call(r), "calls");
+        emit_json(r);
+        result.add(m.name, ns_per_call(r), "ns_per_call");
+        // COUNT| is the bare entry/exit path, the number the mitigations move
+        if (std::strcmp(m.name, "enosys") == 0) {
+            result.count = static_cast<double>(r.iterations);
+            result.iterations = r.iterations;
+            result.elapsed_ns = r.elapsed_ns;
+        }
+    }
+    // ns[]: getpid, getpid-raw, clock-vdso, clock-syscall, enosys
+    result.add("entry_exit", ns[4], "delta_ns");
+    result.add("getpid_work", ns[1] - ns[4], "delta_ns");
+    result.add("glibc_getpid_saving", ns[1] - ns[0], "delta_ns");
+    result.add("vdso_saving", ns[3] - ns[2], "delta_ns");
+    emit_result(result);
+    return EXIT_SUCCESS;
+}
+
+struct UringPoint {
+    unsigned long ops = 0;
+    unsigned long batches = 0;
+    uint64_t ns = 0;
+};
+
+// Queue one round of `batch` SQEs for op; round 1 of "close" closes the fds opened in round 0
+static void prep_round(Uring& ring, const std::string& op, unsigned batch, int round, int zero_fd,
+                       std::vector<int>& fds, std::vector<char>& bufs, std::vector<struct statx>& stx) {
+    for (unsigned i = 0; i < batch; ++i) {
+        io_uring_sqe* sqe = ring.get_sqe();
+        sqe->user_data = i;
+        if (op == "nop") {
+            sqe->opcode = IORING_OP_NOP;
+        } else if (op == "close" && round == 0) {
+            sqe->opcode = IORING_OP_OPENAT;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = reinterpret_cast<uintptr_t>("/dev/null");
+            sqe->open_flags = O_RDONLY | O_CLOEXEC;
+        } else if (op == "close") {
+            sqe->opcode = IORING_OP_CLOSE;
+            sqe->fd = fds[i];
+        } else if (op == "read") {
+            sqe->opcode = IORING_OP_READ;
+            sqe->fd = zero_fd;
+            sqe->addr = reinterpret_cast<uintptr_t>(&bufs[i * 64]);
+            sqe->len = 64;
+            sqe->off = static_cast<uint64_t>(-1);   // current position, like read(2)
+        } else {
+            sqe->opcode = IORING_OP_STATX;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = reinterpret_cast<uintptr_t>("/dev/null");
+            sqe->len = STATX_BASIC_STATS;
+            sqe->off = reinterpret_cast<uintptr_t>(&stx[i]);
+        }
+    }
+}
+
+static UringPoint run_uring_point(Uring& ring, const std::string& op, unsigned batch, double seconds,
+                                  bool gated, LatencyRecorder& lat, const char* prog) {
+    int zero_fd = open("/dev/zero", O_RDONLY | O_CLOEXEC);
+    std::vector<int> fds(batch, -1);
+    std::vector<char> bufs(batch * 64);
+    std::vector<struct statx> stx(batch);
+    int rounds = (op == "close") ? 2 : 1;
+    UringPoint pt;
+
+    BenchTimer timer;
+    timer.start(seconds, gated);
+    while (!timer.expired()) {
+        lat.begin();
+        for (int round = 0; round < rounds; ++round) {
+            prep_round(ring, op, batch, round, zero_fd, fds, bufs, stx);
+            int ret = ring.submit(ring.sqpoll() ? 0 : batch);
+            if (ret < 0) {
+                std::cerr << prog << ": io_uring_enter failed: " << std::strerror(-ret) << std::endl;
+                std::exit(1);
+            }
+            for (unsigned i = 0; i < batch; ++i) {
+                io_uring_cqe* cqe;
+                if (ring.wait_cqe(&cqe) < 0)
+                    std::exit(1);
+                if (cqe->res < 0) {
+                    std::cerr << prog << ": " << op << " failed: " << std::strerror(-cqe->res) << std::endl;
+                    std::exit(1);
+                }
+                fds[cqe->user_data] = cqe->res;
+                ring.cqe_seen();
+            }
+        }
+        lat.end();
+        pt.ops += batch;
+        ++pt.batches;
+    }
+    pt.ns = timer.stop();
+    close(zero_fd);
+    return pt;
+}
+
+static int run_uring(int argc, char* argv[], double duration) {
+    std::string op = (argc > 3) ? argv[3] : "nop";
+    std::string batch_arg = (argc > 4) ? argv[4] : "sweep";
+    bool sqpoll = (argc > 5) && std::strcmp(argv[5], "sqpoll") == 0;
+    if (op != "nop" && op != "close" && op != "read" && op != "statx") {
+        std::cerr << argv[0] << ": unknown uring op " << op << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::vector<unsigned> batches;
+    if (batch_arg == "sweep") {
+        for (unsigned b = 1; b <= 256; b *= 2)
+            batches.push_back(b);
+    } else {
+        long b = std::strtol(batch_arg.c_str(), nullptr, 10);
+        if (b < 1 || b > 256) {
+            std::cerr << argv[0] << ": batch must be 1..256 or sweep" << std::endl;
+            return EXIT_FAILURE;
+        }
+        batches.push_back(static_cast<unsigned>(b));
+    }
+
+    Uring ring;
+    int err = ring.init(256, sqpoll ? IORING_SETUP_SQPOLL : 0, sqpoll ? 1000 : 0);
+    if (err < 0) {
+        std::cerr << argv[0] << ": io_uring_setup failed: " << std::strerror(-err) << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    double slice = batches.size() > 1 ? duration / static_cast<double>(batches.size()) : duration;
+    BenchResult result(bench_name(argv[0]), 0, 0);
+    result.tag("mode", "uring");
+    result.tag("op", op);
+    result.tag("submit", sqpoll ? "sqpoll" : "enter");
+    double best = -1;
+    unsigned best_batch = 0;
+    bool first = true;
+
+    for (unsigned batch : batches) {
+        LatencyRecorder lat;    // UB_LAT_SAMPLE=N times every Nth batch, submit to last CQE
+        UringPoint pt = run_uring_point(ring, op, batch, slice, first, lat, argv[0]);
+        first = false;
+        double ops_per_sec = static_cast<double>(pt.ops) / (static_cast<double>(pt.ns) / 1e9);
+        double batch_ns = pt.batches ? static_cast<double>(pt.ns) / static_cast<double>(pt.batches) : 0;
+
+        BenchResult r(bench_name(argv[0]), pt.ops, pt.ns);
+        r.tag("mode", "uring");
+        r.tag("op", op);
+        r.tag("submit", sqpoll ? "sqpoll" : "enter");
+        r.add("batch", batch, "uring");
+        r.add("batch_ns", batch_ns, "uring");
+        r.add("ns_per_op", pt.ops ? static_cast<double>(pt.ns) / static_cast<double>(pt.ops) : 0, "uring");
+        lat.report(r);
+        if (batches.size() == 1) {
+            result = r;
+            break;
+        }
+        emit_json(r);
+        result.add("b" + std::to_string(batch), ops_per_sec, "ops_per_sec");
+        if (ops_per_sec > best) {
+            best = ops_per_sec;
+            result.count = static_cast<double>(pt.ops);
+            result.iterations = pt.ops;
+            result.elapsed_ns = pt.ns;
+            best_batch = batch;
+        }
+    }
+    if (batches.size() > 1)
+        result.add("best_batch", best_batch, "uring");
+    tag_mitigations(result);
+    emit_result(result);
+    return EXIT_SUCCESS;
+}
+
 int main(int argc, char* argv[]) {
     std::string test;
-    int duration;
+    double duration;
     int fd;
 
     if (argc < 2) {
         std::cerr << "Usage: " << argv[0] << " duration [ test ]" << std::endl
                   << "test is one of:" << std::endl
-                  << "  \"mix\" (default), \"close\", \"getpid\", \"exec\"" << std::endl;
+                  << "  \"mix\" (default), \"close\", \"getpid\", \"exec\"," << std::endl
+                  << "  \"getpid-raw\", \"clock-vdso\", \"clock-syscall\", \"enosys\", \"breakdown\"," << std::endl
+                  << "  \"uring\" [ nop|close|read|statx ] [ batch|sweep ] [ sqpoll ]" << std::endl;
         return EXIT_FAILURE;
     }
 
     test = (argc > 2) ? argv[2] : "mix";
-    duration = std::atoi(argv[1]);
+    duration = parse_duration(argv[1]);
+    if (duration <= 0) {
+        std::cerr << "Invalid duration: " << argv[1] << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (test == "uring")
+        return run_uring(argc, argv, duration);
+    // "getpid" itself stays on the original loop below
+    if (test == "breakdown" || (test != "getpid" && find_call_mode(test)))
+        return run_calls(test, duration, argv[0]);
 
     iter = 0;
-    wake_me(duration, report);
+    LatencyRecorder lat;    // UB_LAT_SAMPLE=N times every Nth iteration
+    BenchTimer timer;
+    timer.start(duration);
 
     switch (test[0]) {
         case 'm':  // mix
             fd = create_fd();
-            while (true) {
+            while (!timer.expired()) {
+                lat.begin();
                 close(dup(fd));
                 getpid();
                 getuid();
                 umask(022);
+                lat.end();
                 ++iter;
             }
             break;
 
         case 'c':  // close only
             fd = create_fd();
-            while (true) {
+            while (!timer.expired()) {
+                lat.begin();
                 close(dup(fd));
+                lat.end();
                 ++iter;
             }
             break;
 
         case 'g':  // getpid only
-            while (true) {
+            while (!timer.expired()) {
+                lat.begin();
                 getpid();
+                lat.end();
                 ++iter;
             }
             break;
 
         case 'e':  // exec
-            while (true) {
+            while (!timer.expired()) {
+                lat.begin();
                 pid_t pid = fork();
                 if (pid < 0) {
                     std::cerr << argv[0] << ": fork failed" << std::endl;
@@ -104,6 +433,7 @@ int main(int argc, char* argv[]) {
                         std::exit(1);
                     }
                 }
+                lat.end();
                 ++iter;
             }
             break;
@@ -111,5 +441,10 @@ int main(int argc, char* argv[]) {
         default:
             return EXIT_FAILURE;
     }
+
+    BenchResult result(bench_name(argv[0]), iter, timer.stop());
+    result.tag("mode", test);
+    lat.report(result);
+    emit_result(result);
     return EXIT_SUCCESS;
 }
@@ -9,93 +9,60 @@
  * This file is a C++ rewrite of time-pollong.c from the original UnixBench project.
  * Original project address: https://github.com/kdlucas/byte-unixbench/tree/v5.1.3
  *
+ * Event notification scaling: the cost of one readiness call, including
+ * dispatching the ready descriptors to their callbacks, as the number of
+ * watched descriptors grows from 1 to MAX_FDS. The descriptors are eventfds;
+ * an active one holds a non-zero count (readable), an idle one is empty.
+ * The active fraction (-a, default 0.01, at least one) is spread evenly.
  *
+ *   select     select(2) on a copied fd_set (only while every fd < FD_SETSIZE)
+ *   poll       poll(2) on a pollfd array
+ *   epoll      epoll_wait(2), level-triggered, interest set built once per point
+ *   epoll-et   epoll_wait(2), edge-triggered; the active eventfds are written
+ *              before every call (outside the timed region) to raise new edges
+ *   uring      io_uring IORING_OP_POLL_ADD: idle fds stay armed, each call
+ *              re-arms the active ones and reaps their completions, the usual
+ *              one-shot io_uring event loop
  *
+ * The original poll2 backend (<linux/poll2.h>, never merged upstream) is gone.
+ *
+ * All descriptor tables are sized at run time. RLIMIT_NOFILE is raised to
+ * what the sweep needs (the hard limit too, up to fs.nr_open, when running
+ * with CAP_SYS_RESOURCE); whatever cannot be had caps the sweep. Memory per
+ * watched fd is reported from /proc/meminfo Slab deltas: once for the
+ * eventfds themselves, and per point for the persistent kernel state of the
+ * epoll interest set and the armed io_uring polls, next to the user-space
+ * bytes each backend keeps per fd. Slab is system wide, so deltas under 1 MiB
+ * are treated as noise and the figure is left out ("unavailable").
+ *
+ * Usage:
+ *   time-polling [-b backends] [-n max_fds] [-a active_fraction] duration
  */
 
 #include <iostream>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
-#include <sys/time.h>
-#include <sys/resource.h>
-#ifdef HAS_POLL
-  #include <poll.h>
-#endif
-#ifdef HAS_POLL2
-  #include <linux/poll2.h>
-#endif
-#include <unistd.h>
-#include <errno.h>
+#include <cerrno>
+#include <fstream>
+#include <string>
 #include <vector>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/select.h>
+#include <unistd.h>
 
-using namespace std;
-
-// Output to stdout if UNIXBENCH is defined, otherwise to stderr
-#ifdef UNIXBENCH
-  #define OUT cout
-#else
-  #define OUT cerr
-#endif
-
-constexpr int TRUE_VALUE = 1;
-constexpr int FALSE_VALUE = 0;
-#ifdef UNIXBENCH
-  constexpr int MAX_ITERATIONS = 1000;
-#else
-  constexpr int MAX_ITERATIONS = 30;
-#endif
-constexpr int MAX_FDS = 40960;
-#define CONST const
-#define ERRSTRING strerror(errno)
-
-// Type flag is defined as int
-using flag = int;
+#include "timeit.hpp"
+#include "result.hpp"
+#include "uring.hpp"
+#include "topology.hpp"
 
-//-------------------------------------------------------------------
-// find_first_set_bit: Find the first set bit in a bit field
-static inline int find_first_set_bit(CONST void *array, int size)
-{
-    int index = 0;
-    unsigned long word;
-    unsigned int ul_size = 8 * sizeof(unsigned long);
-    CONST unsigned long *ul_array = static_cast<CONST unsigned long *>(array);
-
-    // Find the first word that is not all zeros
-    for (; (*ul_array == 0) && (index < size); index += ul_size, ++ul_array);
-    // Find the first set bit in a word
-    for (word = *ul_array; !(word & 1) && (index < size); ++index, word >>= 1);
-    return index;
-}
+using namespace std;
 
-//-------------------------------------------------------------------
-// find_next_set_bit: Find the first set bit after offset
-static inline int find_next_set_bit(CONST void *array, int size, int offset)
-{
-    if (++offset >= size)
-        return offset;
-    int index = offset;
-    unsigned long word;
-    unsigned int ul_size = 8 * sizeof(unsigned long);
-    CONST unsigned long *ul_array = static_cast<CONST unsigned long *>(array);
-
-    // Jump to the long integer containing offset
-    int tmp = offset / ul_size;
-    ul_array += tmp;
-    offset -= tmp * ul_size;
-    if ((offset == 0) || (*ul_array == 0))
-        return find_first_set_bit(ul_array, size - index) + index;
-
-    // Check if there is a set bit in the current word
-    if (((word = *ul_array) != 0) && ((word = word >> offset) != 0))
-    {
-        for (; (word & 1) == 0; word >>= 1, ++index);
-        return index;
-    }
-    // Otherwise check the following word
-    index += ul_size - offset;
-    return find_first_set_bit(++ul_array, size - index) + index;
-}
-//-------------------------------------------------------------------
+constexpr int MAX_FDS = 1 << 20;
+constexpr int RESERVED_FDS = 32;           // stdio, epoll/io_uring descriptors, result emitter
+constexpr unsigned URING_ENTRIES = 4096;   // SQEs per submission chunk
 
 // Callback function structure
 struct callback_struct {
@@ -105,393 +72,439 @@ struct callback_struct {
     void *info;
 };
 
-static int total_bits = 0;
-static callback_struct callbacks[MAX_FDS];
+static long total_bits = 0;
+static vector<callback_struct> callbacks;  // indexed by descriptor number
 
 // A simple test callback
-static void test_func(void *info)
+static void test_func(void *)
 {
     ++total_bits;
 }
 
-#ifdef HAS_SELECT
-//-------------------------------------------------------------------
-// time_select: Test select call time
-static void time_select(fd_set *input_fds, fd_set *output_fds,
-                         fd_set *exception_fds, int max_fd, int num_iter,
-                         long *times)
+// The watched descriptors, in creation order, and which of them are active at this point
+static vector<int> evfds;
+static vector<char> active;
+static vector<struct pollfd> pollfd_array;
+static vector<struct epoll_event> epoll_events;
+
+// Kernel memory held by the current backend's persistent per-fd state, in KiB (-1: none)
+static long setup_slab_kb = -1;
+
+static void die(const char* what)
 {
-    int fd, count, nready;
-    fd_set i_fds, o_fds, e_fds;
-    struct timeval time1, time2, tv;
-
-    // Pre-warming the cache
-    memcpy(&i_fds, input_fds, sizeof(i_fds));
-    memcpy(&o_fds, output_fds, sizeof(i_fds));
-    memcpy(&e_fds, exception_fds, sizeof(i_fds));
-    tv.tv_sec = 0;
-    tv.tv_usec = 0;
-    select(max_fd + 1, &i_fds, &o_fds, &e_fds, &tv);
-    for (count = 0; count < num_iter; ++count)
-    {
-        total_bits = 0;
-        gettimeofday(&time1, nullptr);
-        memcpy(&i_fds, input_fds, sizeof(i_fds));
-        memcpy(&o_fds, output_fds, sizeof(i_fds));
-        memcpy(&e_fds, exception_fds, sizeof(i_fds));
-        tv.tv_sec = 0;
-        tv.tv_usec = 0;
-        nready = select(max_fd + 1, &i_fds, &o_fds, &e_fds, &tv);
-        if (nready == -1)
-        {
-            cerr << "Error selecting\t" << ERRSTRING << endl;
-            exit(2);
-        }
-        if (nready < 1)
-        {
-            cerr << "Error: nready: " << nready << endl;
-            exit(1);
-        }
-        // Handing exception_fds
-        for (fd = find_first_set_bit(&e_fds, sizeof(e_fds) * 8); fd <= max_fd;
-             fd = find_next_set_bit(&e_fds, sizeof(e_fds) * 8, fd))
-        {
-            callbacks[fd].exception_func(callbacks[fd].info);
-        }
-        // Handing input_fds
-        for (fd = find_first_set_bit(&i_fds, sizeof(i_fds) * 8); fd <= max_fd;
-             fd = find_next_set_bit(&i_fds, sizeof(i_fds) * 8, fd))
-        {
-            callbacks[fd].input_func(callbacks[fd].info);
+    cerr << "time-polling: " << what << ": " << strerror(errno) << endl;
+    exit(2);
+}
+
+// Slab: line of /proc/meminfo in KiB, or -1
+static long slab_kb()
+{
+    ifstream in("/proc/meminfo");
+    string key;
+    long kb;
+    while (in >> key >> kb) {
+        if (key == "Slab:")
+            return kb;
+        in.ignore(256, '\n');
+    }
+    return -1;
+}
+
+// Slab is system wide and per-CPU caches grow in whole slabs, so a small difference
+// between two readings is noise; below this many KiB no per-fd figure is reported
+constexpr long SLAB_NOISE_KB = 1024;
+
+// Kernel bytes per descriptor from a Slab difference over n descriptors, -1 if unavailable
+static double slab_bytes_per_fd(long delta_kb, int n)
+{
+    if (delta_kb < SLAB_NOISE_KB || n < 1)
+        return -1;
+    return static_cast<double>(delta_kb) * 1024.0 / n;
+}
+
+// Make exactly num_active of the first n eventfds readable, evenly spread
+static int set_active(int n, int num_active)
+{
+    uint64_t v;
+    for (int i = 0; i < n; ++i) {
+        active[i] = (static_cast<long>(i + 1) * num_active / n) != (static_cast<long>(i) * num_active / n);
+        while (read(evfds[i], &v, sizeof(v)) == sizeof(v)) {
         }
-        // Handing output_fds
-        for (fd = find_first_set_bit(&o_fds, sizeof(o_fds) * 8); fd <= max_fd;
-             fd = find_next_set_bit(&o_fds, sizeof(o_fds) * 8, fd))
-        {
-            callbacks[fd].output_func(callbacks[fd].info);
+        if (active[i]) {
+            v = 1;
+            if (write(evfds[i], &v, sizeof(v)) != sizeof(v))
+                die("eventfd write");
         }
-        gettimeofday(&time2, nullptr);
-        times[count] = (time2.tv_sec - time1.tv_sec) * 1000000 +
-                       (time2.tv_usec - time1.tv_usec);
+    }
+    return num_active;
+}
+
+static void check_ready(const char* backend, int nready, int expected)
+{
+    if (nready != expected) {
+        cerr << "time-polling: " << backend << " reported " << nready << " ready descriptors, expected "
+             << expected << endl;
+        exit(1);
     }
 }
-#endif  // HAS_SELECT
 
-#ifdef HAS_POLL
 //-------------------------------------------------------------------
-// time_poll: Test poll call time
-static void time_poll(struct pollfd *pollfd_array, int start_index,
-                      int num_to_test, int num_iter, long *times)
+// Each backend runs calls until the deadline and returns how many it made;
+// *busy_ns accumulates the time spent inside the timed region.
+
+static long time_select(int n, int num_active, uint64_t deadline, uint64_t* busy_ns)
 {
-    short revents;
-    int fd, count, nready;
-    struct timeval time1, time2;
-    struct pollfd *pollfd_ptr, *stop_pollfd;
-
-    // Pre-warming the cache
-    poll(pollfd_array + start_index, num_to_test, 0);
-    for (count = 0; count < num_iter; ++count)
-    {
-        total_bits = 0;
-        gettimeofday(&time1, nullptr);
-        nready = poll(pollfd_array + start_index, num_to_test, 0);
-        if (nready == -1)
-        {
-            cerr << "Error polling\t" << ERRSTRING << endl;
-            exit(2);
-        }
-        if (nready < 1)
-        {
-            cerr << "Error: nready: " << nready << endl;
-            exit(1);
-        }
-        stop_pollfd = pollfd_array + start_index + num_to_test;
-        for (pollfd_ptr = pollfd_array + start_index; true; ++pollfd_ptr)
-        {
-            if (pollfd_ptr->revents == 0) continue;
-            revents = pollfd_ptr->revents;
-            fd = pollfd_ptr->fd;
-            if (revents & POLLPRI)
-                callbacks[fd].exception_func(callbacks[fd].info);
-            if (revents & POLLIN)
+    fd_set input_fds;
+    int max_fd = 0;
+    FD_ZERO(&input_fds);
+    for (int i = 0; i < n; ++i) {
+        FD_SET(evfds[i], &input_fds);
+        max_fd = max(max_fd, evfds[i]);
+    }
+    long calls = 0;
+    do {
+        uint64_t t0 = now_ns();
+        fd_set i_fds;
+        memcpy(&i_fds, &input_fds, sizeof(i_fds));
+        struct timeval tv = {0, 0};
+        int nready = select(max_fd + 1, &i_fds, nullptr, nullptr, &tv);
+        if (nready < 0)
+            die("select");
+        check_ready("select", nready, num_active);
+        for (int fd = 0; fd <= max_fd; ++fd) {
+            if (FD_ISSET(fd, &i_fds))
                 callbacks[fd].input_func(callbacks[fd].info);
-            if (revents & POLLOUT)
-                callbacks[fd].output_func(callbacks[fd].info);
-            if (--nready == 0) break;
         }
-        gettimeofday(&time2, nullptr);
-        times[count] = (time2.tv_sec - time1.tv_sec) * 1000000 +
-                       (time2.tv_usec - time1.tv_usec);
+        *busy_ns += now_ns() - t0;
+        ++calls;
+    } while (now_ns() < deadline);
+    return calls;
+}
+
+static long time_poll(int n, int num_active, uint64_t deadline, uint64_t* busy_ns)
+{
+    for (int i = 0; i < n; ++i) {
+        pollfd_array[i].fd = evfds[i];
+        pollfd_array[i].events = POLLIN | POLLPRI;
+        pollfd_array[i].revents = 0;
     }
+    long calls = 0;
+    do {
+        uint64_t t0 = now_ns();
+        int nready = poll(pollfd_array.data(), static_cast<nfds_t>(n), 0);
+        if (nready < 0)
+            die("poll");
+        check_ready("poll", nready, num_active);
+        for (struct pollfd* p = pollfd_array.data(); nready > 0; ++p) {
+            if (p->revents == 0)
+                continue;
+            if (p->revents & POLLPRI)
+                callbacks[p->fd].exception_func(callbacks[p->fd].info);
+            if (p->revents & POLLIN)
+                callbacks[p->fd].input_func(callbacks[p->fd].info);
+            --nready;
+        }
+        *busy_ns += now_ns() - t0;
+        ++calls;
+    } while (now_ns() < deadline);
+    return calls;
 }
-#endif  // HAS_POLL
 
-#ifdef HAS_POLL2
-//-------------------------------------------------------------------
-// time_poll2: Test poll2 call time
-static void time_poll2(struct poll2ifd *poll2ifd_array, int start_index,
-                       int num_to_test, int num_iter, long *times)
+static long time_epoll(int n, int num_active, bool edge, uint64_t deadline, uint64_t* busy_ns)
 {
-    short revents;
-    int fd, count, nready, i;
-    struct timeval time1, time2;
-    struct poll2ofd poll2ofd_array[MAX_FDS];
-
-    // Pre-warming the cache
-    poll2(poll2ifd_array + start_index, poll2ofd_array, num_to_test, 0);
-    for (count = 0; count < num_iter; ++count)
-    {
-        total_bits = 0;
-        gettimeofday(&time1, nullptr);
-        nready = poll2(poll2ifd_array + start_index, poll2ofd_array, num_to_test, 0);
-        if (nready == -1)
-        {
-            times[count] = -1;
-            if (errno == ENOSYS) return;
-            cerr << "Error calling poll2(2)\t" << ERRSTRING << endl;
-            exit(2);
+    long slab0 = slab_kb();
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0)
+        die("epoll_create1");
+    for (int i = 0; i < n; ++i) {
+        struct epoll_event ev;
+        ev.events = edge ? (EPOLLIN | EPOLLET) : EPOLLIN;
+        ev.data.fd = evfds[i];
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, evfds[i], &ev) < 0)
+            die("epoll_ctl");
+    }
+    setup_slab_kb = slab_kb() - slab0;
+    long calls = 0;
+    uint64_t one = 1;
+    do {
+        if (edge) {
+            for (int i = 0; i < n; ++i) {
+                if (active[i] && write(evfds[i], &one, sizeof(one)) != sizeof(one))
+                    die("eventfd write");
+            }
         }
-        if (nready < 1)
-        {
-            cerr << "Error: nready: " << nready << endl;
-            exit(1);
+        uint64_t t0 = now_ns();
+        int nready = epoll_wait(epfd, epoll_events.data(), n, 0);
+        if (nready < 0)
+            die("epoll_wait");
+        check_ready(edge ? "epoll-et" : "epoll", nready, num_active);
+        for (int i = 0; i < nready; ++i) {
+            int fd = epoll_events[i].data.fd;
+            callbacks[fd].input_func(callbacks[fd].info);
         }
-        for (i = 0; i < nready; ++i)
-        {
-            revents = poll2ofd_array[i].revents;
-            fd = poll2ofd_array[i].fd;
-            if (revents & POLLPRI)
-                callbacks[fd].exception_func(callbacks[fd].info);
-            if (revents & POLLIN)
-                callbacks[fd].input_func(callbacks[fd].info);
-            if (revents & POLLOUT)
-                callbacks[fd].output_func(callbacks[fd].info);
+        *busy_ns += now_ns() - t0;
+        ++calls;
+    } while (now_ns() < deadline);
+    close(epfd);
+    return calls;
+}
+
+static void uring_poll_add(Uring& ring, int fd)
+{
+    io_uring_sqe* sqe = ring.get_sqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = static_cast<uint64_t>(fd);
+}
+
+static long time_uring(int n, int num_active, uint64_t deadline, uint64_t* busy_ns)
+{
+    long slab0 = slab_kb();
+    Uring ring;
+    int err = ring.init(URING_ENTRIES);
+    if (err < 0) {
+        errno = -err;
+        die("io_uring_setup");
+    }
+    unsigned chunk = ring.sq_entries();
+
+    // Arm the idle descriptors once; they never complete
+    unsigned queued = 0;
+    for (int i = 0; i < n; ++i) {
+        if (active[i])
+            continue;
+        uring_poll_add(ring, evfds[i]);
+        if (++queued == chunk) {
+            if (ring.submit() < 0)
+                die("io_uring_enter");
+            queued = 0;
         }
-        gettimeofday(&time2, nullptr);
-        times[count] = (time2.tv_sec - time1.tv_sec) * 1000000 +
-                       (time2.tv_usec - time1.tv_usec);
     }
+    if (ring.submit() < 0)
+        die("io_uring_enter");
+    setup_slab_kb = slab_kb() - slab0;
+
+    vector<int> ready_fds;
+    for (int i = 0; i < n; ++i) {
+        if (active[i])
+            ready_fds.push_back(evfds[i]);
+    }
+    long calls = 0;
+    do {
+        uint64_t t0 = now_ns();
+        int nready = 0;
+        for (size_t first = 0; first < ready_fds.size(); first += chunk) {
+            size_t last = min(ready_fds.size(), first + chunk);
+            for (size_t k = first; k < last; ++k)
+                uring_poll_add(ring, ready_fds[k]);
+            err = ring.submit(static_cast<unsigned>(last - first));
+            if (err < 0) {
+                errno = -err;
+                die("io_uring_enter");
+            }
+            for (size_t k = first; k < last; ++k) {
+                io_uring_cqe* cqe;
+                if (ring.wait_cqe(&cqe) < 0)
+                    die("io_uring_enter");
+                int fd = static_cast<int>(cqe->user_data);
+                if (cqe->res < 0) {
+                    errno = -cqe->res;
+                    die("IORING_OP_POLL_ADD");
+                }
+                if (cqe->res & POLLIN)
+                    callbacks[fd].input_func(callbacks[fd].info);
+                ring.cqe_seen();
+                ++nready;
+            }
+        }
+        check_ready("uring", nready, num_active);
+        *busy_ns += now_ns() - t0;
+        ++calls;
+    } while (now_ns() < deadline);
+    ring.close();   // cancels the idle polls
+    return calls;
+}
+
+//-------------------------------------------------------------------
+static const char* const backends[] = {"select", "poll", "epoll", "epoll-et", "uring"};
+
+static void usage(const char* prog)
+{
+    cerr << "Usage: " << prog << " [-b backends] [-n max_fds] [-a active_fraction] duration" << endl;
+    cerr << "  -b backends         comma separated subset of:";
+    for (const char* b : backends)
+        cerr << " " << b;
+    cerr << endl;
+    cerr << "  -n max_fds          largest descriptor count of the 1, 2, 4 .. sweep (default " << MAX_FDS
+         << "; RLIMIT_NOFILE is raised as far as allowed)" << endl;
+    cerr << "  -a active_fraction  share of the descriptors that are ready (default 0.01, at least one)" << endl;
+    cerr << "duration is the total time in seconds, shared by all points" << endl;
+    exit(1);
 }
-#endif  // HAS_POLL2
 
 //-------------------------------------------------------------------
 // main function
 int main(int argc, char *argv[]) {
-    flag failed = FALSE;
-    flag verbose = FALSE;
-    int first_fd = -1;
-    int fd, max_fd = 0, count, total_fds = 0;
-    int num_to_test, num_active;
-#ifdef UNIXBENCH
-    int max_iter = 1000;
-#else
-    int max_iter = 10;
-#endif
-#ifdef HAS_SELECT
-    long select_total = 0;
-    fd_set input_fds, output_fds, exception_fds;
-    long select_times[MAX_ITERATIONS];
-#endif
-#ifdef HAS_POLL
-    int start_index = 0;
-    long poll_total = 0;
-    struct pollfd pollfd_array[MAX_FDS];
-    long poll_times[MAX_ITERATIONS];
-#endif
-#ifdef HAS_POLL2
-    long poll2_total = 0;
-    struct poll2ifd poll2ifd_array[MAX_FDS];
-    long poll2_times[MAX_ITERATIONS];
-#endif
-
-#ifdef HAS_SELECT
-    FD_ZERO(&input_fds);
-    FD_ZERO(&output_fds);
-    FD_ZERO(&exception_fds);
-#endif
-#ifdef HAS_POLL
-    memset(pollfd_array, 0, sizeof(pollfd_array));
-#endif
-    // Allocate file descriptors
-    total_fds = 0;
-    while (!failed) {
-        fd = dup(1);
-        if (fd == -1) {
-            if (errno != EMFILE) {
-                cerr << "Error dup()ing\t" << ERRSTRING << endl;
-                exit(1);
-            }
-            failed = TRUE;
-            continue;
-        }
-        if (fd >= MAX_FDS) {
-            cerr << "File descriptor: " << fd
-                 << " larger than max: " << MAX_FDS - 1 << endl;
-            exit(1);
-        }
-        callbacks[fd].input_func = test_func;
-        callbacks[fd].output_func = test_func;
-        callbacks[fd].exception_func = test_func;
-        callbacks[fd].info = nullptr;
-        if (fd > max_fd)
-            max_fd = fd;
-        if (first_fd < 0)
-            first_fd = fd;
-#ifdef HAS_POLL
-        pollfd_array[fd].fd = fd;
-        pollfd_array[fd].events = 0;
-#endif
-#ifdef HAS_POLL2
-        poll2ifd_array[fd].fd = fd;
-        poll2ifd_array[fd].events = 0;
-#endif
-        total_fds++;
+    int max_fds = MAX_FDS;
+    double fraction = 0.01;
+    string backend_list;
+
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; ++arg) {
+        if (strcmp(argv[arg], "-b") == 0 && arg + 1 < argc)
+            backend_list = argv[++arg];
+        else if (strcmp(argv[arg], "-n") == 0 && arg + 1 < argc)
+            max_fds = atoi(argv[++arg]);
+        else if (strcmp(argv[arg], "-a") == 0 && arg + 1 < argc)
+            fraction = atof(argv[++arg]);
+        else
+            usage(argv[0]);
     }
-    total_fds = max_fd + 1;
-    // Processing command line arguments
-    if (argc > 5) {
-        cerr << "Usage:\ttime-polling [num_iter] [num_to_test] [num_active] [-v]" << endl;
+    if (arg >= argc || max_fds < 1 || fraction < 0 || fraction > 1)
+        usage(argv[0]);
+    double duration = parse_duration(argv[arg]);
+    if (duration <= 0) {
+        cerr << "Invalid duration: " << argv[arg] << endl;
         exit(1);
     }
-    if (argc > 1)
-        max_iter = std::atoi(argv[1]);
-    if (max_iter > MAX_ITERATIONS) {
-        cerr << "num_iter too large" << endl;
-        exit(1);
+
+    rlim_t limit = raise_nofile(static_cast<rlim_t>(max_fds) + RESERVED_FDS);
+    if (limit < static_cast<rlim_t>(max_fds) + RESERVED_FDS) {
+        max_fds = max(1, static_cast<int>(limit) - RESERVED_FDS);
+        cerr << "time-polling: RLIMIT_NOFILE " << limit << " limits the sweep to " << max_fds
+             << " descriptors" << endl;
     }
-    if (argc > 2)
-        num_to_test = std::atoi(argv[2]);
-    else
-        num_to_test = total_fds - first_fd;
-    if (argc > 3)
-        num_active = std::atoi(argv[3]);
-    else
-        num_active = 1;
-    if (argc > 4) {
-        if (string(argv[4]) != "-v") {
-            cerr << "Usage:\ttime-polling [num_iter] [num_to_test] [num_active] [-v]" << endl;
-            exit(1);
+    evfds.resize(max_fds);
+    active.resize(max_fds);
+    pollfd_array.resize(max_fds);
+    epoll_events.resize(max_fds);
+    callbacks.resize(static_cast<size_t>(max_fds) + RESERVED_FDS);
+
+    long slab0 = slab_kb();
+    for (int i = 0; i < max_fds; ++i) {
+        evfds[i] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (evfds[i] < 0) {
+            // Out of memory or fs.file-max: sweep what we have
+            if (i == 0 || (errno != EMFILE && errno != ENFILE && errno != ENOMEM))
+                die("eventfd");
+            cerr << "time-polling: eventfd: " << strerror(errno) << ", sweep limited to " << i
+                 << " descriptors" << endl;
+            max_fds = i;
+            evfds.resize(max_fds);
+            break;
         }
-        verbose = TRUE;
-    }
-    if (num_to_test > total_fds - first_fd)
-        num_to_test = total_fds - first_fd;
-    if (num_active > total_fds - first_fd)
-        num_active = total_fds - first_fd;
-
-#ifdef HAS_SELECT
-    for (fd = total_fds - num_to_test; fd < total_fds; ++fd) {
-        FD_SET(fd, &exception_fds);
-        FD_SET(fd, &input_fds);
-    }
-#endif
-#ifdef HAS_POLL
-    for (fd = total_fds - num_to_test; fd < total_fds; ++fd) {
-        pollfd_array[fd].events = POLLPRI | POLLIN;
+        if (static_cast<size_t>(evfds[i]) >= callbacks.size())
+            callbacks.resize(static_cast<size_t>(evfds[i]) * 2);
+        callbacks[evfds[i]] = {test_func, test_func, test_func, nullptr};
     }
-#endif
-#ifdef HAS_POLL2
-    for (fd = total_fds - num_to_test; fd < total_fds; ++fd) {
-        poll2ifd_array[fd].events = POLLPRI | POLLIN;
-    }
-#endif
-#ifdef HAS_SELECT
-    for (fd = total_fds - num_active; fd < total_fds; ++fd) {
-        FD_SET(fd, &output_fds);
-    }
-#endif
-#ifdef HAS_POLL
-    for (fd = total_fds - num_active; fd < total_fds; ++fd) {
-        pollfd_array[fd].events |= POLLOUT;
-    }
-#endif
-#ifdef HAS_POLL2
-    for (fd = total_fds - num_active; fd < total_fds; ++fd) {
-        poll2ifd_array[fd].events |= POLLOUT;
-    }
-#endif
-
-    OUT << "Num fds: " << total_fds << ", polling descriptors "
-        << total_fds - num_to_test << "-" << max_fd << "\n";
-
-#ifdef HAS_SELECT
-    time_select(&input_fds, &output_fds, &exception_fds, max_fd, max_iter, select_times);
-#endif
-#ifdef HAS_POLL
-    start_index = total_fds - num_to_test;
-    time_poll(pollfd_array, start_index, num_to_test, max_iter, poll_times);
-#endif
-#ifdef HAS_POLL2
-    start_index = total_fds - num_to_test;
-    time_poll2(poll2ifd_array, start_index, num_to_test, max_iter, poll2_times);
-#endif
-
-    OUT << "All times in microseconds\n";
-    OUT << "ITERATION\t";
-#ifdef HAS_SELECT
-    OUT << "select(2)" << "\t";
-#endif
-#ifdef HAS_POLL
-    OUT << "poll(2)" << "\t";
-#endif
-#ifdef HAS_POLL2
-    if (poll2_times[0] >= 0) OUT << "poll2(2)" << "\t";
-#endif
-    OUT << "\n";
-
-    for (count = 0; count < max_iter; ++count) {
-        if (verbose) OUT << count << "\t\t";
-#ifdef HAS_SELECT
-        if (verbose) OUT << select_times[count] << "\t";
-        select_total += select_times[count];
-#endif
-#ifdef HAS_POLL
-        if (verbose) OUT << poll_times[count] << "\t";
-        poll_total += poll_times[count];
-#endif
-#ifdef HAS_POLL2
-        if (verbose && (poll2_times[0] >= 0))
-            OUT << poll2_times[count] << "\t";
-        poll2_total += poll2_times[count];
-#endif
-        if (verbose) OUT << "\n";
+    double eventfd_bytes = slab0 >= 0 ? slab_bytes_per_fd(slab_kb() - slab0, max_fds) : -1;
+
+    vector<int> counts;
+    for (int n = 1; n < max_fds; n *= 2)
+        counts.push_back(n);
+    counts.push_back(max_fds);
+
+    vector<const char*> run_backends;
+    for (const char* b : backends) {
+        if (in_list(backend_list, b))
+            run_backends.push_back(b);
     }
-    OUT << "\n\naverage\t\t";
-#ifdef HAS_SELECT
-    OUT << (select_total / max_iter) << "\t";
-#endif
-#ifdef HAS_POLL
-    OUT << (poll_total / max_iter) << "\t";
-#endif
-#ifdef HAS_POLL2
-    if (poll2_times[0] >= 0)
-        OUT << (poll2_total / max_iter) << "\t";
-#endif
-    OUT << "\nPer fd\t\t";
-#ifdef HAS_SELECT
-    OUT << ((float)select_total / (float)max_iter / (float)num_to_test) << "\t";
-#ifdef UNIXBENCH
-    cerr << "lps\t" << 1000000.0 * max_iter * num_to_test / select_total
-         << "\t" << ((float)select_total / 1000000.0) << "\n";
-#endif
-#endif
-#ifdef HAS_POLL
-    OUT << ((float)poll_total / (float)max_iter / (float)num_to_test) << "\t";
-#ifdef UNIXBENCH
-    cerr << "lps\t" << 1000000.0 * max_iter * num_to_test / poll_total
-         << "\t" << ((float)poll_total / 1000000.0) << "\n";
-#endif
-#endif
-#ifdef HAS_POLL2
-    if (poll2_times[0] >= 0) {
-        OUT << ((float)poll2_total / (float)max_iter / (float)num_to_test) << "\t";
-#ifdef UNIXBENCH
-        cerr << "lps\t" << 1000000.0 * max_iter * num_to_test / poll2_total
-             << "\t" << ((float)poll2_total / 1000000.0) << "\n";
-#endif
+    if (run_backends.empty())
+        usage(argv[0]);
+    double slice = max(duration / static_cast<double>(counts.size() * run_backends.size()), 0.01);
+
+    string eventfd_text = eventfd_bytes >= 0 ? to_string(static_cast<long>(eventfd_bytes + 0.5)) : "unknown";
+    printf("time-polling: 1..%d eventfds (%s kernel bytes each), %.2f%% active, %.3f s per point\n", max_fds,
+           eventfd_text.c_str(), fraction * 100, slice);
+    printf("%-9s %7s %7s %12s %14s %10s %10s\n", "backend", "fds", "active", "calls", "ns/call", "ns/fd", "bytes/fd");
+
+    BenchResult result;
+    result.name = "time-polling";
+    result.unit = "calls";
+    result.add("active_fraction", fraction, "config");
+    result.add("max_fds", max_fds, "config");
+    if (eventfd_bytes >= 0)
+        result.add("eventfd_kernel_bytes", eventfd_bytes, "memory");
+    else
+        result.tag("eventfd_kernel_bytes", "unavailable");
+    result.tag("backend", run_backends.front());
+    bool first = true;
+    int headline_fds = 0;
+
+    for (const char* b : run_backends) {
+        string name = b;
+        for (int n : counts) {
+            // select cannot name descriptors at or above FD_SETSIZE
+            if (name == "select" && evfds[n - 1] >= FD_SETSIZE)
+                continue;
+            int num_active = max(1, static_cast<int>(n * fraction + 0.5));
+            set_active(n, num_active);
+
+            uint64_t t0, t1;
+            if (first) {
+                start_gate(slice, t0, t1);
+                first = false;
+            } else {
+                t0 = now_ns();
+                t1 = t0 + static_cast<uint64_t>(slice * 1e9);
+            }
+            uint64_t busy = 0;
+            long calls;
+            total_bits = 0;
+            setup_slab_kb = -1;
+            if (name == "select")
+                calls = time_select(n, num_active, t1, &busy);
+            else if (name == "poll")
+                calls = time_poll(n, num_active, t1, &busy);
+            else if (name == "epoll" || name == "epoll-et")
+                calls = time_epoll(n, num_active, name == "epoll-et", t1, &busy);
+            else
+                calls = time_uring(n, num_active, t1, &busy);
+
+            double ns_per_call = static_cast<double>(busy) / static_cast<double>(calls);
+            double ns_per_fd = ns_per_call / n;
+            // Per-fd state the backend keeps between calls: the kernel side only for epoll and io_uring
+            double kernel_bytes = setup_slab_kb >= 0 ? slab_bytes_per_fd(setup_slab_kb, n) : -1;
+            size_t user_bytes = name == "select"  ? 0
+                              : name == "poll"    ? sizeof(struct pollfd)
+                              : name == "uring"   ? sizeof(io_uring_sqe)
+                                                  : sizeof(struct epoll_event);
+            string kernel_text = kernel_bytes >= 0 ? to_string(static_cast<long>(kernel_bytes + 0.5)) : "-";
+            printf("%-9s %7d %7d %12ld %14.1f %10.2f %10s\n", b, n, num_active, calls, ns_per_call, ns_per_fd,
+                   kernel_text.c_str());
+
+            BenchResult r("time-polling", static_cast<unsigned long>(calls), busy, "calls");
+            r.count = 1e9 / ns_per_call;
+            r.tag("backend", b);
+            r.add("fds", n, "point");
+            r.add("active", num_active, "point");
+            r.add("ns_per_call", ns_per_call, "point");
+            r.add("ns_per_fd", ns_per_fd, "point");
+            r.add("callbacks", static_cast<double>(total_bits), "point");
+            if (kernel_bytes >= 0)
+                r.add("kernel_bytes_per_fd", kernel_bytes, "point");
+            r.add("user_bytes_per_fd", static_cast<double>(user_bytes), "point");
+            emit_json(r);
+
+            string key = name + "_n" + to_string(n);
+            result.add(key, ns_per_call, "ns_per_call");
+            if (kernel_bytes >= 0 && n == max_fds)
+                result.add(name + "_kernel_bytes_per_fd", kernel_bytes, "memory");
+            // Headline: the first backend at its largest descriptor count
+            if (b == run_backends.front()) {
+                result.count = 1e9 / ns_per_call;
+                result.iterations = static_cast<unsigned long>(calls);
+                result.elapsed_ns = busy;
+                headline_fds = n;
+            }
+        }
     }
-#endif
-    OUT << "<- the most important value\n";
+    fflush(stdout);
 
+    for (int i = 0; i < max_fds; ++i)
+        close(evfds[i]);
+    result.add("fds", headline_fds, "config");
+    emit_result(result);
     return 0;
-}
\ No newline at end of file
+}
@@ -1,24 +1,203 @@
 /**
  * @file        timeit.cpp
- * @brief       C++ refactored UnixBench arith test module
+ * @brief       Shared high-resolution timing core for the UnixBench benchmarks
  * @author      rRNA
- * @version     3.4.0
- * @date        04-28-2025
+ * @version     4.0.0
+ * @date        10-17-2026
  *
  * @details
- * This file is a C++ rewrite of timeit.c from the original UnixBench project.
+ * This file started as a C++ rewrite of timeit.c from the original UnixBench project.
  * Original project address: https://github.com/kdlucas/byte-unixbench/tree/v5.1.3
  *
- *
- *
+ * It is now built into the ubcommon library and linked into every benchmark.
  */
 
+#include "timeit.hpp"
+#include "perfcount.hpp"
+
+#include <cstdlib>
+#include <cmath>
 #include <csignal>
+#include <ctime>
+#include <fcntl.h>
 #include <unistd.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+
+std::atomic<bool> bench_stop{false};
+
+static_assert(std::atomic<bool>::is_always_lock_free, "bench_stop must be usable from a signal handler");
+
+uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+uint64_t tsc_now() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+    uint64_t v;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(v));
+    return v;
+#else
+    return now_ns();
+#endif
+}
+
+double tsc_ns_per_tick() {
+    // Calibrate over ~20ms against the monotonic clock; done once per process
+    static const double ratio = [] {
+        uint64_t n0 = now_ns(), c0 = tsc_now();
+        struct timespec nap = {0, 20000000};
+        nanosleep(&nap, nullptr);
+        uint64_t n1 = now_ns(), c1 = tsc_now();
+        return (c1 > c0) ? static_cast<double>(n1 - n0) / static_cast<double>(c1 - c0) : 1.0;
+    }();
+    return ratio;
+}
+
+double parse_duration(const char* arg) {
+    if (arg == nullptr)
+        return -1.0;
+    char* end = nullptr;
+    double seconds = std::strtod(arg, &end);
+    if (end == arg || *end != '\0' || !std::isfinite(seconds))
+        return -1.0;
+    return seconds;
+}
+
+bool in_list(const std::string& list, const char* name) {
+    if (list.empty())
+        return true;
+    size_t pos = 0;
+    while (pos <= list.size()) {
+        size_t comma = list.find(',', pos);
+        if (comma == std::string::npos)
+            comma = list.size();
+        if (list.compare(pos, comma - pos, name) == 0)
+            return true;
+        pos = comma + 1;
+    }
+    return false;
+}
+
+// Layout of the shared gate file (zero-filled by the harness)
+struct StartGate {
+    std::atomic<uint32_t> arrived;
+    std::atomic<uint32_t> open;     // futex word
+    std::atomic<uint64_t> t0_ns;
+    std::atomic<uint64_t> t1_ns;
+};
+
+constexpr uint64_t GATE_LEAD_NS = 10000000ULL;     // time for every waiter to wake before t0
+constexpr long GATE_TIMEOUT_SEC = 120;             // give up on copies that never arrive
+
+void sleep_until(uint64_t deadline_ns) {
+    struct timespec ts = {static_cast<time_t>(deadline_ns / 1000000000ULL),
+                          static_cast<long>(deadline_ns % 1000000000ULL)};
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) != 0) {
+    }
+}
+
+bool start_gate(double seconds, uint64_t& t0, uint64_t& t1) {
+    const char* path = std::getenv("UB_START_GATE");
+    const char* copies_env = std::getenv("UB_START_COPIES");
+    long copies = copies_env ? std::strtol(copies_env, nullptr, 10) : 0;
+    t0 = now_ns();
+    t1 = t0 + static_cast<uint64_t>(seconds * 1e9);
+    if (path == nullptr || copies < 1)
+        return false;
+
+    int fd = open(path, O_RDWR);
+    void* map = (fd >= 0) ? mmap(nullptr, sizeof(StartGate), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    if (fd >= 0)
+        close(fd);
+    // Children (spawn, exec, looper commands) must not try to join the gate again
+    unsetenv("UB_START_GATE");
+    if (map == MAP_FAILED)
+        return false;
+
+    auto* gate = static_cast<StartGate*>(map);
+    if (gate->arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == static_cast<uint32_t>(copies)) {
+        // Last copy to arrive opens the gate and publishes the common window
+        uint64_t w0 = now_ns() + GATE_LEAD_NS;
+        gate->t0_ns.store(w0, std::memory_order_relaxed);
+        gate->t1_ns.store(w0 + static_cast<uint64_t>(seconds * 1e9), std::memory_order_relaxed);
+        gate->open.store(1, std::memory_order_release);
+        syscall(SYS_futex, &gate->open, FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+    } else {
+        uint64_t give_up = now_ns() + GATE_TIMEOUT_SEC * 1000000000ULL;
+        while (gate->open.load(std::memory_order_acquire) == 0) {
+            uint64_t now = now_ns();
+            if (now >= give_up)
+                break;
+            struct timespec rel = {static_cast<time_t>((give_up - now) / 1000000000ULL),
+                                   static_cast<long>((give_up - now) % 1000000000ULL)};
+            syscall(SYS_futex, &gate->open, FUTEX_WAIT, 0, &rel, nullptr, 0);
+        }
+    }
+
+    bool opened = gate->open.load(std::memory_order_acquire) != 0;
+    if (opened) {
+        t0 = gate->t0_ns.load(std::memory_order_relaxed);
+        t1 = gate->t1_ns.load(std::memory_order_relaxed);
+        sleep_until(t0);
+    } else {
+        t0 = now_ns();
+        t1 = t0 + static_cast<uint64_t>(seconds * 1e9);
+    }
+    munmap(map, sizeof(StartGate));
+    return opened;
+}
+
+// The handler only stores the flag; everything else happens in the benchmark loop
+static void on_timer(int) {
+    bench_stop.store(true, std::memory_order_relaxed);
+}
+
+void BenchTimer::start(double seconds, bool gated) {
+    struct sigaction sa = {};
+    sa.sa_handler = on_timer;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;   // blocking read()/wait() resume, the loop then sees the flag
+    sigaction(SIGALRM, &sa, nullptr);
+
+    bench_stop.store(false, std::memory_order_relaxed);
+    t1 = 0;
+
+    // Counters (UB_PERF) are opened before the gate, so their setup syscalls stay
+    // out of the window, but only enabled once it opens: the wait for the other
+    // copies is not counted
+    process_counters().open();
+
+    uint64_t end = 0;
+    bool shared = gated && start_gate(seconds, t0, end);
+    process_counters().start();
+    if (!shared) {
+        t0 = now_ns();
+        end = t0 + static_cast<uint64_t>(seconds * 1e9);
+    }
+
+    // Arm for the absolute end of the window
+    struct itimerval it = {};
+    uint64_t now = now_ns();
+    long usec = (end > now) ? static_cast<long>((end - now) / 1000) : 0;
+    if (usec < 1)
+        usec = 1;
+    it.it_value.tv_sec = usec / 1000000;
+    it.it_value.tv_usec = usec % 1000000;
+    setitimer(ITIMER_REAL, &it, nullptr);
+}
 
-void wake_me(int seconds, void (*func)(int)) {
-    // Set the signal handler, the callback function must now accept an int parameter
-    std::signal(SIGALRM, func);
-    // Start Timer
-    alarm(seconds);
-}
\ No newline at end of file
+uint64_t BenchTimer::stop() {
+    t1 = now_ns();
+    struct itimerval off = {};
+    setitimer(ITIMER_REAL, &off, nullptr);
+    process_counters().stop();
+    bench_stop.store(true, std::memory_order_relaxed);
+    return t1 - t0;
+}
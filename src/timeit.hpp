@@ -0,0 +1,72 @@
+/**
+ * @file        timeit.hpp
+ * @brief       Shared high-resolution timing core for the UnixBench benchmarks
+ * @author      rRNA
+ * @version     4.0.0
+ * @date        10-17-2026
+ *
+ * @details
+ * The original timeit.c armed a one-second alarm() whose handler printed the
+ * score and called exit() from signal context. Benchmarks now poll a cheap
+ * atomic stop flag instead; the interval timer only stores that flag, and the
+ * elapsed time is taken from CLOCK_MONOTONIC so sub-second runs are exact.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Set when the measurement window closes. Lock-free, so it is safe to store from a signal handler.
+extern std::atomic<bool> bench_stop;
+
+// Nanoseconds from CLOCK_MONOTONIC (shared by all processes on the host)
+uint64_t now_ns();
+
+// Raw cycle counter (rdtsc / cntvct), falls back to now_ns() on other targets
+uint64_t tsc_now();
+
+// Nanoseconds per tsc_now() tick, calibrated once against CLOCK_MONOTONIC
+double tsc_ns_per_tick();
+
+// Parse a duration in seconds, fractions allowed ("0.25"). Returns a value <= 0 on bad input.
+double parse_duration(const char* arg);
+
+// True if name is one of the comma separated entries of list; an empty list selects everything
+bool in_list(const std::string& list, const char* name);
+
+// Sleep until an absolute CLOCK_MONOTONIC time in nanoseconds, resuming after signals
+void sleep_until(uint64_t deadline_ns);
+
+// Cross-process start gate. When UB_START_GATE names a shared file and UB_START_COPIES
+// the number of copies, every copy blocks (futex) until the last one arrives; that copy
+// publishes a common window [t0, t1] which all copies then use. Returns false (t0 = now)
+// when no gate is configured. The gate is consumed once per process.
+bool start_gate(double seconds, uint64_t& t0, uint64_t& t1);
+
+// Measurement window: start() arms an ITIMER_REAL interval timer that sets bench_stop,
+// the measured loop polls expired(), and stop() records the end timestamp.
+// With gated set, the window is the shared one from start_gate().
+class BenchTimer {
+public:
+    void start(double seconds, bool gated = true);
+    uint64_t stop();
+
+    bool expired() const { return bench_stop.load(std::memory_order_relaxed); }
+    uint64_t start_ns() const { return t0; }
+    uint64_t elapsed_ns() const { return (t1 ? t1 : now_ns()) - t0; }
+
+private:
+    uint64_t t0 = 0;
+    uint64_t t1 = 0;
+};
+
+// Spin-wait hint for busy loops (barriers, spinlocks)
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
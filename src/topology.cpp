@@ -0,0 +1,328 @@
+/**
+ * @file        topology.cpp
+ * @brief       CPU, cache and NUMA topology helpers shared by the threaded benchmarks
+ * @author      rRNA
+ * @version     4.0.0
+ * @date        10-17-2026
+ *
+ * @details
+ * Everything is read from sched_getaffinity() and sysfs so the helpers work in
+ * the static binaries without libnuma or hwloc.
+ */
+
+#include "topology.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+// From <numaif.h>, which belongs to libnuma
+constexpr int UB_MPOL_DEFAULT = 0;
+constexpr int UB_MPOL_BIND = 2;
+constexpr unsigned UB_MPOL_MF_STRICT = 1u << 0;
+constexpr unsigned UB_MPOL_MF_MOVE = 1u << 1;
+constexpr int UB_MAX_NODES = 1024;
+
+std::vector<int> allowed_cpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set))
+                cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+bool pin_thread(int cpu) {
+    if (cpu < 0)
+        return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+// Parse a sysfs cache size such as "32K" or "36864K"
+static size_t parse_cache_size(const char* text) {
+    char* end = nullptr;
+    unsigned long long v = std::strtoull(text, &end, 10);
+    if (end && (*end == 'K' || *end == 'k'))
+        v <<= 10;
+    else if (end && (*end == 'M' || *end == 'm'))
+        v <<= 20;
+    return static_cast<size_t>(v);
+}
+
+size_t llc_size(size_t fallback) {
+    // Highest cache level listed for CPU 0 that holds data
+    size_t best = 0;
+    int best_level = 0;
+    for (int index = 0; index < 8; ++index) {
+        char path[128], buf[64];
+        std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/level", index);
+        FILE* f = std::fopen(path, "r");
+        if (f == nullptr)
+            break;
+        int level = 0;
+        if (std::fscanf(f, "%d", &level) != 1)
+            level = 0;
+        std::fclose(f);
+
+        std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/type", index);
+        f = std::fopen(path, "r");
+        if (f == nullptr)
+            continue;
+        bool instruction = std::fgets(buf, sizeof(buf), f) && std::strncmp(buf, "Instruction", 11) == 0;
+        std::fclose(f);
+        if (instruction || level < best_level)
+            continue;
+
+        std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/size", index);
+        f = std::fopen(path, "r");
+        if (f == nullptr)
+            continue;
+        if (std::fgets(buf, sizeof(buf), f)) {
+            best = parse_cache_size(buf);
+            best_level = level;
+        }
+        std::fclose(f);
+    }
+#ifdef _SC_LEVEL3_CACHE_SIZE
+    if (best == 0) {
+        long v = sysconf(_SC_LEVEL3_CACHE_SIZE);
+        if (v > 0)
+            best = static_cast<size_t>(v);
+    }
+#endif
+    return best ? best : fallback;
+}
+
+// Read one integer from a sysfs file, -1 if it is missing
+static int read_int(const char* path) {
+    FILE* f = std::fopen(path, "r");
+    if (f == nullptr)
+        return -1;
+    int v = -1;
+    if (std::fscanf(f, "%d", &v) != 1)
+        v = -1;
+    std::fclose(f);
+    return v;
+}
+
+// Parse a sysfs cpu/node list such as "0-3,8-11"
+static std::vector<int> read_list(const char* path) {
+    std::vector<int> out;
+    FILE* f = std::fopen(path, "r");
+    if (f == nullptr)
+        return out;
+    char buf[4096];
+    if (std::fgets(buf, sizeof(buf), f)) {
+        char* p = buf;
+        while (*p && *p != '\n') {
+            char* end = nullptr;
+            long lo = std::strtol(p, &end, 10);
+            if (end == p)
+                break;
+            long hi = lo;
+            if (*end == '-')
+                hi = std::strtol(end + 1, &end, 10);
+            for (long v = lo; v <= hi; ++v)
+                out.push_back(static_cast<int>(v));
+            p = (*end == ',') ? end + 1 : end;
+        }
+    }
+    std::fclose(f);
+    return out;
+}
+
+std::vector<int> numa_nodes() {
+    std::vector<int> nodes = read_list("/sys/devices/system/node/has_memory");
+    if (nodes.empty())
+        nodes = read_list("/sys/devices/system/node/online");
+    if (nodes.empty())
+        nodes.push_back(0);
+    return nodes;
+}
+
+std::vector<CpuTopo> cpu_topology() {
+    // Node of every CPU from the node side, CPUs without a node stay on 0
+    std::vector<int> node_of(CPU_SETSIZE, 0);
+    for (int node : read_list("/sys/devices/system/node/online")) {
+        char path[128];
+        std::snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        for (int cpu : read_list(path)) {
+            if (cpu >= 0 && cpu < CPU_SETSIZE)
+                node_of[cpu] = node;
+        }
+    }
+
+    std::vector<CpuTopo> cpus;
+    for (int cpu : allowed_cpus()) {
+        char path[128];
+        CpuTopo t = {cpu, cpu, 0, node_of[cpu], true};
+        std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/core_id", cpu);
+        int core = read_int(path);
+        std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+        int package = read_int(path);
+        std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", cpu);
+        std::vector<int> siblings = read_list(path);
+        if (core >= 0)
+            t.core = core;
+        if (package >= 0)
+            t.package = package;
+        if (!siblings.empty())
+            t.primary = (*std::min_element(siblings.begin(), siblings.end()) == cpu);
+        cpus.push_back(t);
+    }
+    return cpus;
+}
+
+std::vector<int> node_cpus(int node) {
+    std::vector<int> out;
+    for (const auto& t : cpu_topology()) {
+        if (t.node == node)
+            out.push_back(t.cpu);
+    }
+    return out;
+}
+
+std::vector<int> place_cpus(const std::string& policy, int copies) {
+    std::vector<CpuTopo> cpus = cpu_topology();
+    std::vector<int> order;
+    if (cpus.empty() || copies < 1)
+        return order;
+
+    auto compact_less = [](const CpuTopo& a, const CpuTopo& b) {
+        if (a.node != b.node)
+            return a.node < b.node;
+        if (a.package != b.package)
+            return a.package < b.package;
+        if (a.core != b.core)
+            return a.core < b.core;
+        return a.cpu < b.cpu;
+    };
+    // Whole cores first, then the remaining SMT siblings, each in compact order
+    auto cores_first_less = [&](const CpuTopo& a, const CpuTopo& b) {
+        if (a.primary != b.primary)
+            return a.primary;
+        return compact_less(a, b);
+    };
+
+    if (policy == "compact") {
+        std::sort(cpus.begin(), cpus.end(), compact_less);
+        for (const auto& t : cpus)
+            order.push_back(t.cpu);
+    } else if (policy == "core") {
+        std::sort(cpus.begin(), cpus.end(), cores_first_less);
+        for (const auto& t : cpus)
+            order.push_back(t.cpu);
+    } else if (policy == "scatter" || policy == "node") {
+        std::sort(cpus.begin(), cpus.end(), cores_first_less);
+        std::vector<std::vector<int>> per_node;
+        std::vector<int> node_ids;
+        for (const auto& t : cpus) {
+            auto it = std::find(node_ids.begin(), node_ids.end(), t.node);
+            if (it == node_ids.end()) {
+                node_ids.push_back(t.node);
+                per_node.emplace_back();
+                it = node_ids.end() - 1;
+            }
+            per_node[it - node_ids.begin()].push_back(t.cpu);
+        }
+        if (policy == "node") {
+            // Copy i lives on node i % nodes and cycles through that node's CPUs, so
+            // unequal nodes still get an equal share of the copies
+            std::vector<int> placed;
+            for (int i = 0; i < copies; ++i) {
+                const auto& list = per_node[static_cast<size_t>(i) % per_node.size()];
+                placed.push_back(list[(static_cast<size_t>(i) / per_node.size()) % list.size()]);
+            }
+            return placed;
+        }
+        for (size_t round = 0; order.size() < cpus.size(); ++round) {
+            for (const auto& list : per_node) {
+                if (round < list.size())
+                    order.push_back(list[round]);
+            }
+        }
+    } else {
+        return order;
+    }
+
+    std::vector<int> placed;
+    for (int i = 0; i < copies; ++i)
+        placed.push_back(order[static_cast<size_t>(i) % order.size()]);
+    return placed;
+}
+
+bool mbind_node(void* addr, size_t len, int node) {
+    if (node < 0 || node >= UB_MAX_NODES)
+        return false;
+    unsigned long mask[UB_MAX_NODES / (8 * sizeof(unsigned long))] = {};
+    mask[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+    return syscall(SYS_mbind, addr, len, UB_MPOL_BIND, mask, UB_MAX_NODES + 1,
+                   UB_MPOL_MF_MOVE | UB_MPOL_MF_STRICT) == 0;
+}
+
+bool bind_memory(int node) {
+    if (node < 0)
+        return syscall(SYS_set_mempolicy, UB_MPOL_DEFAULT, nullptr, 0) == 0;
+    if (node >= UB_MAX_NODES)
+        return false;
+    unsigned long mask[UB_MAX_NODES / (8 * sizeof(unsigned long))] = {};
+    mask[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+    return syscall(SYS_set_mempolicy, UB_MPOL_BIND, mask, UB_MAX_NODES + 1) == 0;
+}
+
+int memory_node(int cpu, const std::string& mem) {
+    if (mem != "local" && mem != "remote")
+        return -1;
+    std::vector<int> nodes = numa_nodes();
+    int local = nodes.front();
+    for (const auto& t : cpu_topology()) {
+        if (t.cpu == cpu) {
+            local = t.node;
+            break;
+        }
+    }
+    if (mem == "local" || nodes.size() < 2)
+        return local;
+    for (int n : nodes) {
+        if (n > local)
+            return n;
+    }
+    return nodes.front();
+}
+
+rlim_t raise_nofile(rlim_t wanted) {
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) != 0)
+        return 0;
+    if (rl.rlim_cur == RLIM_INFINITY || rl.rlim_cur >= wanted)
+        return rl.rlim_cur;
+    if (rl.rlim_max != RLIM_INFINITY && rl.rlim_max < wanted) {
+        // Only a privileged process may lift the hard limit, and never past fs.nr_open
+        unsigned long long nr_open = wanted;
+        if (FILE* f = std::fopen("/proc/sys/fs/nr_open", "r")) {
+            if (std::fscanf(f, "%llu", &nr_open) != 1)
+                nr_open = wanted;
+            std::fclose(f);
+        }
+        rlim_t cap = std::min(wanted, static_cast<rlim_t>(nr_open));
+        struct rlimit want = {cap, cap};
+        if (want.rlim_max > rl.rlim_max && setrlimit(RLIMIT_NOFILE, &want) == 0)
+            return want.rlim_cur;
+    }
+    rl.rlim_cur = rl.rlim_max == RLIM_INFINITY ? wanted : std::min(wanted, rl.rlim_max);
+    setrlimit(RLIMIT_NOFILE, &rl);
+    getrlimit(RLIMIT_NOFILE, &rl);
+    return rl.rlim_cur;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file        topology.hpp
+ * @brief       CPU, cache and NUMA topology helpers shared by the threaded benchmarks
+ * @author      rRNA
+ * @version     4.0.0
+ * @date        10-17-2026
+ *
+ * @details
+ * Placement policies (same names as Run.py --placement):
+ *   compact   fill one core's SMT siblings, then the next core, node by node
+ *   scatter   round-robin over NUMA nodes, whole cores first, siblings last
+ *   core      one copy per physical core (no SMT sharing) until cores run out
+ *   node      copy i on NUMA node i % nnodes, cycling through that node's CPUs
+ *
+ * Memory placement uses the raw mbind/set_mempolicy system calls, so there is
+ * no libnuma dependency.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+
+struct CpuTopo {
+    int cpu;
+    int core;       // core_id, unique within the package
+    int package;    // physical_package_id (socket)
+    int node;       // NUMA node, 0 without NUMA
+    bool primary;   // first SMT sibling of its core
+};
+
+// CPUs this process may run on, in ascending order
+std::vector<int> allowed_cpus();
+
+// Pin the calling thread to one CPU; false if the kernel refused
+bool pin_thread(int cpu);
+
+// Size in bytes of the last level cache seen by CPU 0, or fallback if it cannot be read
+size_t llc_size(size_t fallback = 32u << 20);
+
+// Topology of the allowed CPUs, ascending by CPU number
+std::vector<CpuTopo> cpu_topology();
+
+// NUMA nodes that have memory, ascending; {0} on non-NUMA systems
+std::vector<int> numa_nodes();
+
+// Allowed CPUs of one NUMA node
+std::vector<int> node_cpus(int node);
+
+// One CPU per copy for the given policy (compact, scatter, core, node); empty for an unknown policy.
+// Wraps around when there are more copies than CPUs.
+std::vector<int> place_cpus(const std::string& policy, int copies);
+
+// Bind the pages of [addr, addr + len) to node, migrating any already touched
+bool mbind_node(void* addr, size_t len, int node);
+
+// Memory policy of the calling thread for future allocations: bind to node, or -1 for the default
+bool bind_memory(int node);
+
+// Memory node for a copy on cpu as in Run.py --mem: "local" is the CPU's node, "remote"
+// the next node with memory (the local one on single-node systems); -1 for anything else
+int memory_node(int cpu, const std::string& mem);
+
+// Raise RLIMIT_NOFILE so that `wanted` descriptors fit, lifting the hard limit too (up to
+// fs.nr_open) when the process is privileged; returns the soft limit in effect
+rlim_t raise_nofile(rlim_t wanted);
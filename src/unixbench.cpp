@@ -0,0 +1,234 @@
+/**
+ * @file        unixbench.cpp
+ * @brief       Multi-call benchmark binary running the CPU kernels on pinned threads
+ * @author      rRNA
+ * @version     4.0.0
+ * @date        10-17-2026
+ *
+ * @details
+ * Run.py gets its parallelism by launching one process per copy, which costs
+ * a fork/exec per copy and lets the copies start at different times. This
+ * binary links dhry, whetstone, the arith variants and hanoi as kernels and
+ * runs N copies on pinned std::thread workers. All workers wait at a start
+ * barrier and are released together, then run until a common stop flag is
+ * set, so every copy measures the same window.
+ *
+ * Usage:
+ *   unixbench [-c copies] [-n | -p policy] [-m local|remote] kernel duration [disks]
+ *   <kernel> duration            (multi-call: invoked through a symlink)
+ */
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sched.h>
+#include <ctime>
+
+#include "timeit.hpp"
+#include "result.hpp"
+#include "kernels.hpp"
+#include "perfcount.hpp"
+#include "topology.hpp"
+
+using namespace std;
+
+// Number of disks for the hanoi kernel (second positional argument)
+static int hanoi_disks = 10;
+
+static unsigned long hanoi_kernel(const std::atomic<bool>& stop) {
+    return hanoi_run(hanoi_disks, stop);
+}
+
+struct Kernel {
+    const char* name;
+    const char* unit;
+    unsigned long (*run)(const std::atomic<bool>& stop);
+    double rate_scale;      // > 0: count = iterations * rate_scale / seconds (whetstone MWIPS)
+};
+
+static const Kernel kernels[] = {
+    {"dhry",             "lps",   dhry_run,           0},
+    {"dhry_reg",         "lps",   dhry_run,           0},
+    {"whetstone-double", "mwips", whetstone_run,      10.0},   // 100 (x100) / 10 per pass
+    {"hanoi",            "lps",   hanoi_kernel,       0},
+    {"arithoh",          "lps",   arith_run_arithoh,  0},
+    {"register",         "lps",   arith_run_register, 0},
+    {"short",            "lps",   arith_run_short,    0},
+    {"int",              "lps",   arith_run_int,      0},
+    {"long",             "lps",   arith_run_long,     0},
+    {"float",            "lps",   arith_run_float,    0},
+    {"double",           "lps",   arith_run_double,   0},
+};
+
+// Per-copy state, padded so workers never share a cache line
+struct alignas(64) Slot {
+    unsigned long iterations = 0;
+    uint64_t start_ns = 0;
+    uint64_t end_ns = 0;
+    int cpu = -1;
+};
+
+static std::atomic<int> ready{0};
+static std::atomic<bool> go{false};
+static std::atomic<bool> stop{false};
+
+static const Kernel* find_kernel(const string& name) {
+    for (const auto& k : kernels) {
+        if (name == k.name)
+            return &k;
+    }
+    return nullptr;
+}
+
+static void usage(const char* prog) {
+    cerr << "Usage: " << prog << " [-c copies] [-n | -p policy] [-m local|remote] kernel duration [disks]" << endl;
+    cerr << "  -c copies   number of concurrent worker threads (default 1)" << endl;
+    cerr << "  -n          do not pin workers to CPUs" << endl;
+    cerr << "  -p policy   placement: compact, scatter, core or node (default: ascending CPU number)" << endl;
+    cerr << "  -m mem      bind each worker's memory to the node of its CPU (local) or the next one (remote)" << endl;
+    cerr << "kernel is one of:";
+    for (const auto& k : kernels)
+        cerr << " " << k.name;
+    cerr << endl;
+    exit(1);
+}
+
+static void worker(const Kernel* k, Slot* slot, int pin_cpu, int mem_node) {
+    pin_thread(pin_cpu);
+    if (mem_node >= 0)
+        bind_memory(mem_node);
+
+    // Start barrier: spin so the release reaches every copy within microseconds
+    ready.fetch_add(1, std::memory_order_acq_rel);
+    while (!go.load(std::memory_order_acquire))
+        cpu_relax();
+
+    slot->start_ns = now_ns();
+    slot->iterations = k->run(stop);
+    slot->end_ns = now_ns();
+    slot->cpu = sched_getcpu();
+}
+
+int main(int argc, char* argv[]) {
+    int copies = 1;
+    bool pin = true;
+    string policy, mem;
+    int arg = 1;
+
+    // Multi-call: a symlink named after a kernel runs that kernel directly
+    string kernel_name = bench_name(argv[0]);
+    const Kernel* k = find_kernel(kernel_name);
+
+    if (k == nullptr) {
+        for (; arg < argc && argv[arg][0] == '-'; ++arg) {
+            if (strcmp(argv[arg], "-c") == 0 && arg + 1 < argc) {
+                copies = atoi(argv[++arg]);
+            } else if (strcmp(argv[arg], "-n") == 0) {
+                pin = false;
+            } else if (strcmp(argv[arg], "-p") == 0 && arg + 1 < argc) {
+                policy = argv[++arg];
+            } else if (strcmp(argv[arg], "-m") == 0 && arg + 1 < argc) {
+                mem = argv[++arg];
+                if (mem != "local" && mem != "remote")
+                    usage(argv[0]);
+            } else {
+                usage(argv[0]);
+            }
+        }
+        if (arg >= argc)
+            usage(argv[0]);
+        kernel_name = argv[arg++];
+        k = find_kernel(kernel_name);
+        if (k == nullptr) {
+            cerr << "Unknown kernel: " << kernel_name << endl;
+            usage(argv[0]);
+        }
+    }
+
+    if (arg >= argc || copies < 1)
+        usage(argv[0]);
+    double duration = parse_duration(argv[arg++]);
+    if (duration <= 0) {
+        cerr << "Invalid duration: " << argv[arg - 1] << endl;
+        exit(1);
+    }
+    if (arg < argc)
+        hanoi_disks = atoi(argv[arg]);
+
+    // Opened before the workers exist so every thread inherits them (UB_PERF)
+    PerfCounters counters;
+    counters.open();
+
+    vector<int> cpus = policy.empty() ? allowed_cpus() : place_cpus(policy, copies);
+    if (cpus.empty() && !policy.empty()) {
+        cerr << "Unknown placement policy: " << policy << endl;
+        usage(argv[0]);
+    }
+    vector<Slot> slots(copies);
+    vector<thread> workers;
+    workers.reserve(copies);
+    for (int i = 0; i < copies; ++i) {
+        int cpu = (pin && !cpus.empty()) ? cpus[i % cpus.size()] : -1;
+        workers.emplace_back(worker, k, &slots[i], cpu, memory_node(cpu, mem));
+    }
+
+    while (ready.load(std::memory_order_acquire) < copies)
+        std::this_thread::yield();
+
+    // Open the common window [t0, t1] and release every copy at once; when several
+    // unixbench processes share a start gate the window is the gate's
+    uint64_t t0, t1;
+    start_gate(duration, t0, t1);
+    counters.start();
+    go.store(true, std::memory_order_release);
+
+    struct timespec deadline = {static_cast<time_t>(t1 / 1000000000ULL), static_cast<long>(t1 % 1000000000ULL)};
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) != 0) {
+    }
+    stop.store(true, std::memory_order_relaxed);
+    counters.stop();
+
+    for (auto& t : workers)
+        t.join();
+
+    // One result per copy, then the aggregate
+    double total = 0;
+    uint64_t first_start = UINT64_MAX, last_start = 0, last_end = 0;
+    for (int i = 0; i < copies; ++i) {
+        const Slot& s = slots[i];
+        BenchResult r(k->name, s.iterations, s.end_ns - t0, k->unit);
+        if (k->rate_scale > 0)
+            r.count = static_cast<double>(s.iterations) * k->rate_scale / (static_cast<double>(r.elapsed_ns) / 1e9);
+        r.cpu = s.cpu;
+        r.tag("copy", to_string(i));
+        emit_result(r);
+
+        total += r.count;
+        first_start = min(first_start, s.start_ns);
+        last_start = max(last_start, s.start_ns);
+        last_end = max(last_end, s.end_ns);
+    }
+
+    BenchResult sum;
+    sum.name = k->name;
+    sum.unit = k->unit;
+    sum.count = total;
+    sum.elapsed_ns = last_end - t0;
+    for (const auto& s : slots)
+        sum.iterations += s.iterations;
+    sum.tag("mode", "threads");
+    if (pin && !policy.empty())
+        sum.tag("placement", policy);
+    if (!mem.empty())
+        sum.tag("mem", mem);
+    sum.add("copies", copies, "multi");
+    sum.add("pinned", pin ? 1 : 0, "multi");
+    sum.add("start_skew_ns", static_cast<double>(last_start - first_start), "multi");
+    sum.add("stop_overrun_ns", static_cast<double>(last_end - t1), "multi");
+    counters.report(sum);
+    emit_json(sum);
+    return 0;
+}
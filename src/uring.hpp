@@ -0,0 +1,98 @@
+/**
+ * @file        uring.hpp
+ * @brief       Minimal io_uring ring on raw system calls (no liburing)
+ * @author      rRNA
+ * @version     4.0.0
+ * @date        10-17-2026
+ *
+ * @details
+ * Just enough of io_uring for the benchmarks: set up and map a ring, hand out
+ * SQEs, submit them (without io_uring_enter() when an SQPOLL thread is
+ * awake), and reap CQEs. Opcode-specific fields are filled in by the caller
+ * on the SQE returned by get_sqe(), as with liburing's io_uring_prep_*().
+ *
+ *     Uring ring;
+ *     if (ring.init(64) < 0) ...;
+ *     io_uring_sqe* sqe = ring.get_sqe();
+ *     sqe->opcode = IORING_OP_NOP;
+ *     ring.submit(1);                  // submit and wait for one completion
+ *     io_uring_cqe* cqe = ring.peek_cqe();
+ *     ...cqe->res...
+ *     ring.cqe_seen();
+ *
+ * One thread per ring; nothing here is thread safe.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <linux/io_uring.h>
+
+struct iovec;
+
+class Uring {
+public:
+    Uring() = default;
+    ~Uring();
+    Uring(const Uring&) = delete;
+    Uring& operator=(const Uring&) = delete;
+
+    // Set up a ring of at least `entries` SQEs. flags are IORING_SETUP_*, sq_thread_idle_ms
+    // applies to IORING_SETUP_SQPOLL. Returns 0 or -errno.
+    int init(unsigned entries, unsigned flags = 0, unsigned sq_thread_idle_ms = 0);
+    void close();
+
+    bool ready() const { return ring_fd >= 0; }
+    bool sqpoll() const { return setup_flags & IORING_SETUP_SQPOLL; }
+    unsigned features() const { return feature_flags; }
+    unsigned sq_entries() const { return sq_size; }
+
+    // A zeroed SQE to fill in, or nullptr when the submission queue is full
+    io_uring_sqe* get_sqe();
+
+    // Publish the SQEs taken since the last call and, unless an SQPOLL thread picks them up
+    // by itself, enter the kernel; waits for min_complete completions. Returns the number
+    // of SQEs published or -errno.
+    int submit(unsigned min_complete = 0);
+
+    // Oldest unseen completion, or nullptr
+    io_uring_cqe* peek_cqe();
+    // Block until a completion is available (with SQPOLL: spin briefly first)
+    int wait_cqe(io_uring_cqe** cqe);
+    void cqe_seen() { cq_advance(1); }
+    void cq_advance(unsigned n);
+
+    // IORING_REGISTER_FILES / IORING_REGISTER_BUFFERS; 0 or -errno
+    int register_files(const int* fds, unsigned n);
+    int register_buffers(const struct iovec* iov, unsigned n);
+
+private:
+    unsigned flush();
+    int enter(unsigned to_submit, unsigned min_complete, unsigned flags);
+
+    int ring_fd = -1;
+    unsigned setup_flags = 0;
+    unsigned feature_flags = 0;
+
+    void* sq_map = nullptr;
+    size_t sq_map_len = 0;
+    void* cq_map = nullptr;
+    size_t cq_map_len = 0;
+    io_uring_sqe* sqes = nullptr;
+    size_t sqes_len = 0;
+
+    unsigned* sq_head = nullptr;
+    unsigned* sq_tail = nullptr;
+    unsigned* sq_flags = nullptr;
+    unsigned* sq_array = nullptr;
+    unsigned sq_mask = 0;
+    unsigned sq_size = 0;
+    unsigned sqe_head = 0;   // first SQE not yet published
+    unsigned sqe_tail = 0;   // next SQE to hand out
+
+    unsigned* cq_head = nullptr;
+    unsigned* cq_tail = nullptr;
+    io_uring_cqe* cqes = nullptr;
+    unsigned cq_mask = 0;
+};
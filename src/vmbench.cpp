@@ -0,0 +1,315 @@
+/**
+ * @file        vmbench.cpp
+ * @brief       Virtual memory benchmark (page faults, mmap/munmap, mprotect, MADV_DONTNEED)
+ * @author      rRNA
+ * @version     4.0.0
+ * @date        10-17-2026
+ *
+ * @details
+ * Exercises the kernel's address space paths from 1..N pinned threads that all
+ * share one mm, so mmap_lock and page table lock contention show up as the
+ * thread count grows:
+ *
+ *   fault_4k     touch freshly mapped anonymous memory (MADV_NOHUGEPAGE);
+ *                one op is one 4 KiB minor fault, munmap included
+ *   fault_thp    the same with MADV_HUGEPAGE on 2 MiB aligned regions; one op
+ *                is one 2 MiB fault (skipped when THP is disabled)
+ *   mmap_churn   mmap + munmap of 64 KiB, never touched; one op is the pair
+ *   mprotect     flip one page of a populated 64-page region between
+ *                read-only and read-write (a VMA split and merge); one op is
+ *                one mprotect call
+ *   dontneed     MADV_DONTNEED 64 populated pages, then fault them back in;
+ *                one op is one page reclaimed and refaulted
+ *
+ * Each point reports operations per second, nanoseconds per operation per
+ * thread and minor faults per operation (getrusage), which shows whether a
+ * fault_thp op really was a huge page fault.
+ *
+ * Usage:
+ *   vmbench [-t max_threads] [-p policy] [-b benches] duration
+ */
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <climits>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "timeit.hpp"
+#include "result.hpp"
+#include "topology.hpp"
+#include "workpool.hpp"
+
+using namespace std;
+
+constexpr int MAX_THREADS = 1024;
+constexpr size_t HUGE_BYTES = 2 * 1024 * 1024;
+constexpr size_t FAULT_BYTES = 4 * 1024 * 1024;   // per mapping in the fault tests
+constexpr size_t CHURN_BYTES = 64 * 1024;
+constexpr size_t REGION_PAGES = 64;
+
+static size_t page_bytes = 4096;
+static std::atomic<bool> stop{false};
+
+// -------------------------------------------------------------- benches ----
+static char* map_anon(size_t bytes) {
+    void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        perror("vmbench: mmap");
+        exit(1);
+    }
+    return static_cast<char*>(p);
+}
+
+// Map, touch every page, unmap
+static unsigned long run_fault_4k(int, const std::atomic<bool>& stop) {
+    unsigned long ops = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+        char* p = map_anon(FAULT_BYTES);
+        madvise(p, FAULT_BYTES, MADV_NOHUGEPAGE);
+        for (size_t off = 0; off < FAULT_BYTES; off += page_bytes)
+            p[off] = 1;
+        munmap(p, FAULT_BYTES);
+        ops += FAULT_BYTES / page_bytes;
+    }
+    return ops;
+}
+
+// Over-map by one huge page so the touched range is 2 MiB aligned
+static unsigned long run_fault_thp(int, const std::atomic<bool>& stop) {
+    unsigned long ops = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+        char* raw = map_anon(FAULT_BYTES + HUGE_BYTES);
+        char* p = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(raw) + HUGE_BYTES - 1) & ~(HUGE_BYTES - 1));
+        madvise(p, FAULT_BYTES, MADV_HUGEPAGE);
+        for (size_t off = 0; off < FAULT_BYTES; off += HUGE_BYTES)
+            p[off] = 1;
+        munmap(raw, FAULT_BYTES + HUGE_BYTES);
+        ops += FAULT_BYTES / HUGE_BYTES;
+    }
+    return ops;
+}
+
+static unsigned long run_mmap_churn(int, const std::atomic<bool>& stop) {
+    unsigned long ops = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+        char* p = map_anon(CHURN_BYTES);
+        munmap(p, CHURN_BYTES);
+        ++ops;
+    }
+    return ops;
+}
+
+static unsigned long run_mprotect(int, const std::atomic<bool>& stop) {
+    size_t bytes = REGION_PAGES * page_bytes;
+    char* p = map_anon(bytes);
+    memset(p, 1, bytes);
+    char* target = p + (REGION_PAGES / 2) * page_bytes;
+    unsigned long ops = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+        mprotect(target, page_bytes, PROT_READ);
+        mprotect(target, page_bytes, PROT_READ | PROT_WRITE);
+        ops += 2;
+    }
+    munmap(p, bytes);
+    return ops;
+}
+
+static unsigned long run_dontneed(int, const std::atomic<bool>& stop) {
+    size_t bytes = REGION_PAGES * page_bytes;
+    char* p = map_anon(bytes);
+    madvise(p, bytes, MADV_NOHUGEPAGE);
+    memset(p, 1, bytes);
+    unsigned long ops = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+        madvise(p, bytes, MADV_DONTNEED);
+        for (size_t off = 0; off < bytes; off += page_bytes)
+            p[off] = 1;
+        ops += REGION_PAGES;
+    }
+    munmap(p, bytes);
+    return ops;
+}
+
+struct Bench {
+    const char* name;
+    unsigned long (*run)(int tid, const std::atomic<bool>& stop);
+    bool needs_thp;
+};
+
+static const Bench benches[] = {
+    {"fault_4k",   run_fault_4k,   false},
+    {"fault_thp",  run_fault_thp,  true},
+    {"mmap_churn", run_mmap_churn, false},
+    {"mprotect",   run_mprotect,   false},
+    {"dontneed",   run_dontneed,   false},
+};
+
+// The bracketed word of /sys/kernel/mm/transparent_hugepage/enabled, or "unavailable"
+static string thp_mode() {
+    ifstream in("/sys/kernel/mm/transparent_hugepage/enabled");
+    string line;
+    if (!getline(in, line))
+        return "unavailable";
+    size_t open = line.find('['), close = line.find(']');
+    if (open == string::npos || close == string::npos || close < open)
+        return "unavailable";
+    return line.substr(open + 1, close - open - 1);
+}
+
+// ---------------------------------------------------------------- driver ----
+struct alignas(64) Slot {
+    unsigned long ops = 0;
+};
+
+static const Bench* current = nullptr;
+static long minor_faults() {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_minflt;
+}
+
+static void usage(const char* prog) {
+    cerr << "Usage: " << prog << " [-t max_threads] [-p policy] [-b benches] duration" << endl;
+    cerr << "  -t max_threads  largest thread count of the 1, 2, 4, ... sweep (default: allowed CPUs)" << endl;
+    cerr << "  -p policy       placement: compact, scatter, core or node (default compact)" << endl;
+    cerr << "  -b benches      comma separated subset of:";
+    for (const auto& b : benches)
+        cerr << " " << b.name;
+    cerr << endl;
+    cerr << "duration is the total time in seconds, shared by all points" << endl;
+    exit(1);
+}
+
+int main(int argc, char* argv[]) {
+    int max_threads = static_cast<int>(allowed_cpus().size());
+    string policy = "compact";
+    string bench_list;
+
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; ++arg) {
+        if (strcmp(argv[arg], "-t") == 0 && arg + 1 < argc)
+            max_threads = atoi(argv[++arg]);
+        else if (strcmp(argv[arg], "-p") == 0 && arg + 1 < argc)
+            policy = argv[++arg];
+        else if (strcmp(argv[arg], "-b") == 0 && arg + 1 < argc)
+            bench_list = argv[++arg];
+        else
+            usage(argv[0]);
+    }
+    if (arg >= argc || max_threads < 1 || max_threads > MAX_THREADS)
+        usage(argv[0]);
+    double duration = parse_duration(argv[arg]);
+    if (duration <= 0) {
+        cerr << "Invalid duration: " << argv[arg] << endl;
+        exit(1);
+    }
+    page_bytes = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+
+    vector<int> counts;
+    for (int t = 1; t < max_threads; t *= 2)
+        counts.push_back(t);
+    counts.push_back(max_threads);
+
+    string thp = thp_mode();
+    bool thp_usable = thp == "always" || thp == "madvise";
+    vector<const Bench*> run_benches;
+    for (const auto& b : benches) {
+        if (!in_list(bench_list, b.name))
+            continue;
+        if (b.needs_thp && !thp_usable) {
+            cerr << "vmbench: skipping " << b.name << " (transparent hugepages: " << thp << ")" << endl;
+            continue;
+        }
+        run_benches.push_back(&b);
+    }
+    vector<int> cpus = place_cpus(policy, max_threads);
+    if (run_benches.empty() || cpus.empty())
+        usage(argv[0]);
+
+    double slice = max(duration / static_cast<double>(counts.size() * run_benches.size()), 0.05);
+
+    // One pool of max_threads workers; points with fewer threads leave the rest asleep
+    vector<Slot> slots(max_threads);
+    WorkerPool pool;
+    pool.start(vector<int>(cpus.begin(), cpus.begin() + max_threads),
+               [&](int tid) { slots[tid].ops = current->run(tid, stop); });
+
+    printf("vmbench: threads 1..%d, placement %s, THP %s, %.3f s per point\n", max_threads, policy.c_str(),
+           thp.c_str(), slice);
+    printf("%-12s %7s %16s %12s %12s\n", "bench", "threads", "ops/s", "ns/op", "faults/op");
+
+    BenchResult result;
+    result.name = "vmbench";
+    result.unit = "ops";
+    result.tag("placement", policy);
+    result.tag("thp", thp);
+    bool first = true;
+
+    for (const Bench* b : run_benches) {
+        for (int n : counts) {
+            current = b;
+            for (auto& s : slots)
+                s.ops = 0;
+            stop.store(false, std::memory_order_relaxed);
+
+            uint64_t t0, t1;
+            if (first) {
+                start_gate(slice, t0, t1);
+                first = false;
+            } else {
+                t0 = now_ns();
+                t1 = t0 + static_cast<uint64_t>(slice * 1e9);
+            }
+            long faults0 = minor_faults();
+            pool.release(n);
+            sleep_until(t1);
+            stop.store(true, std::memory_order_relaxed);
+            pool.wait();
+            uint64_t elapsed = now_ns() - t0;
+            long faults = minor_faults() - faults0;
+
+            unsigned long total = 0;
+            for (int i = 0; i < n; ++i)
+                total += slots[i].ops;
+            double secs = static_cast<double>(elapsed) / 1e9;
+            double ops_per_sec = static_cast<double>(total) / secs;
+            double ns_per_op = total ? static_cast<double>(elapsed) * n / static_cast<double>(total) : 0;
+            double faults_per_op = total ? static_cast<double>(faults) / static_cast<double>(total) : 0;
+            printf("%-12s %7d %16.0f %12.2f %12.3f\n", b->name, n, ops_per_sec, ns_per_op, faults_per_op);
+
+            BenchResult r("vmbench", total, elapsed, "ops");
+            r.count = ops_per_sec;
+            r.tag("bench", b->name);
+            r.add("threads", n, "point");
+            r.add("ns_per_op", ns_per_op, "point");
+            r.add("faults_per_op", faults_per_op, "point");
+            emit_json(r);
+
+            string key = string(b->name) + "_t" + to_string(n);
+            result.add(key, ops_per_sec, "ops_per_sec");
+            result.add(key, ns_per_op, "ns_per_op");
+            // Headline: the first bench at the largest thread count
+            if (b == run_benches.front() && n == max_threads) {
+                result.count = ops_per_sec;
+                result.iterations = total;
+                result.elapsed_ns = elapsed;
+                result.tag("bench", b->name);
+            }
+        }
+    }
+
+    pool.stop();
+    fflush(stdout);
+
+    result.add("max_threads", max_threads, "config");
+    emit_result(result);
+    return 0;
+}
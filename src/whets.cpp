@@ -18,6 +18,10 @@
 #include <chrono>
 #include <vector>
 #include <iomanip>
+#include "timeit.hpp"
+#include "result.hpp"
+#include "perfcount.hpp"
+#include "kernels.hpp"
 
 using namespace std;
 
@@ -39,15 +43,14 @@ void p3(SPDP *x, SPDP *y, SPDP *z, SPDP t, SPDP t1, SPDP t2);
 void pout(const string& title, float ops, int type, SPDP checknum,
     SPDP time, int calibrate, int section);
 
-// Static global variables:
-static vector<SPDP> loop_time(9);
-static vector<SPDP> loop_mops(9);
-static vector<SPDP> loop_mflops(9);
-static SPDP TimeUsed;
-static SPDP mwips;
-static array<string, 9> headings;
-static SPDP Check;
-static vector<SPDP> results(9);
+// Static global variables (per thread in the unixbench binary):
+static UB_TLS vector<SPDP> loop_time(9);
+static UB_TLS vector<SPDP> loop_mops(9);
+static UB_TLS vector<SPDP> loop_mflops(9);
+static UB_TLS SPDP TimeUsed;
+static UB_TLS array<string, 9> headings;
+static UB_TLS SPDP Check;
+static UB_TLS vector<SPDP> results(9);
 
 // Define a function that returns the number of seconds since a fixed point, of type double
 double dtime() {
@@ -56,12 +59,26 @@ double dtime() {
     return std::chrono::duration<double>(clock::now() - start).count();
 }
 
+// Kernel entry: repeat single passes (x100 = 100) until stopped; pout() stays silent
+// because calibrate is neither 0 (report) nor 1 (record check values)
+unsigned long whetstone_run(const std::atomic<bool>& stop) {
+    unsigned long passes = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+        TimeUsed = 0;
+        whetstones(1, 100, 2);
+        passes++;
+    }
+    return passes;
+}
+
+#ifndef UB_KERNEL
 // main
 int main(int argc, char *argv[]) {
     ios::sync_with_stdio(false);
     cin.tie(nullptr);
     cout << "Starting the Whetstone Double-Precision Benchmark..." << endl;
 
+    SPDP mwips;
     int count = 10, calibrate = 1;
     long xtra = 1;
     long x100 = 100;
@@ -111,7 +128,26 @@ int main(int argc, char *argv[]) {
     cout << "\nLoop content                  Result              MFLOPS      MOPS   Seconds" << endl << endl;
 
     TimeUsed = 0;
-    whetstones(xtra, x100, calibrate);
+    process_counters().open();
+    // Calibration takes a different time in every copy; the timed pass starts together
+    // at the shared start gate (UB_START_GATE), as BenchTimer does for the other tests
+    uint64_t gate_t0, gate_t1;
+    bool shared = start_gate(duration, gate_t0, gate_t1);
+    process_counters().start();
+    if (shared) {
+        // All copies must also stop at t1: a short reported pass gives the section
+        // figures, then single passes (as whetstone_run) fill the rest of the window
+        long reported = xtra / 10 > 0 ? xtra / 10 : 1;
+        whetstones(reported, x100, calibrate);
+        xtra = reported;
+        while (now_ns() < gate_t1) {
+            whetstones(1, x100, 2);
+            xtra++;
+        }
+    } else {
+        whetstones(xtra, x100, calibrate);
+    }
+    process_counters().stop();
 
     cout << "\nMWIPS            ";
     if (TimeUsed > 0) {
@@ -133,10 +169,29 @@ int main(int argc, char *argv[]) {
     cout << "Please submit feedback and results files to aburto@nosc.mil or to" << endl;
     cout << "Roy_Longbottom@compuserve.com" << endl << endl;
 
-    std::cout << "COUNT|" << std::fixed << std::setprecision(3) << mwips << "|1|mwips" << std::endl;
+    cout.flush();
+
+    // Report MWIPS with every section's MFLOPS/MOPS as sub-metrics
+    BenchResult result;
+    result.name = bench_name(argv[0]);
+    result.unit = "mwips";
+    result.count = std::round(mwips * 1000.0) / 1000.0;
+    result.elapsed_ns = static_cast<uint64_t>(TimeUsed * 1e9);
+    result.iterations = static_cast<uint64_t>(xtra) * static_cast<uint64_t>(x100);
+    result.tag("precision", Precision);
+    for (int section = 1; section <= 8; ++section) {
+        string key = headings[section].substr(0, 2);
+        if (loop_mops[section] == 99999)
+            result.add(key + "_mflops", loop_mflops[section], "sections");
+        else
+            result.add(key + "_mops", loop_mops[section], "sections");
+        result.add(key + "_seconds", loop_time[section], "sections");
+    }
+    emit_result(result);
 
     return 0;
 }
+#endif
 
 void whetstones(long xtra, long x100, int calibrate) {
     long n1, n2, n3, n4, n5, n6, n7, n8, i, ix, n1mult;
@@ -0,0 +1,85 @@
+/**
+ * @file        workpool.cpp
+ * @brief       Persistent pool of pinned worker threads for the thread-sweep benchmarks
+ * @author      rRNA
+ * @version     4.0.0
+ * @date        10-17-2026
+ */
+
+#include "workpool.hpp"
+#include "topology.hpp"
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static void futex_wait(std::atomic<uint32_t>* word, uint32_t val) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT_PRIVATE, val, nullptr, nullptr, 0);
+}
+
+static void futex_wake(std::atomic<uint32_t>* word, int n) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE_PRIVATE, n, nullptr, nullptr, 0);
+}
+
+void WorkerPool::start(const std::vector<int>& cpus, Body b, Body i, Body f) {
+    body = std::move(b);
+    init = std::move(i);
+    fini = std::move(f);
+    gates.reset(new Gate[cpus.size()]);
+    quit.store(false, std::memory_order_relaxed);
+    ready.store(0, std::memory_order_relaxed);
+    for (size_t t = 0; t < cpus.size(); ++t)
+        threads.emplace_back(&WorkerPool::worker, this, static_cast<int>(t), cpus[t]);
+    while (ready.load(std::memory_order_acquire) < size())
+        std::this_thread::yield();
+}
+
+void WorkerPool::worker(int tid, int cpu) {
+    pin_thread(cpu);
+    if (init)
+        init(tid);
+    Gate& gate = gates[tid];
+    uint32_t seen = 0;
+    ready.fetch_add(1, std::memory_order_acq_rel);
+    for (;;) {
+        uint32_t go;
+        while ((go = gate.go.load(std::memory_order_acquire)) == seen)
+            futex_wait(&gate.go, seen);
+        seen = go;
+        if (quit.load(std::memory_order_acquire))
+            break;
+        body(tid);
+        done.fetch_add(1, std::memory_order_acq_rel);
+        futex_wake(&done, 1);
+    }
+    if (fini)
+        fini(tid);
+}
+
+void WorkerPool::release(int n) {
+    active = static_cast<uint32_t>(n < size() ? n : size());
+    done.store(0, std::memory_order_relaxed);
+    for (uint32_t t = 0; t < active; ++t) {
+        gates[t].go.fetch_add(1, std::memory_order_acq_rel);
+        futex_wake(&gates[t].go, 1);
+    }
+}
+
+void WorkerPool::wait() {
+    uint32_t d;
+    while ((d = done.load(std::memory_order_acquire)) < active)
+        futex_wait(&done, d);
+}
+
+void WorkerPool::stop() {
+    if (threads.empty())
+        return;
+    quit.store(true, std::memory_order_release);
+    for (int t = 0; t < size(); ++t) {
+        gates[t].go.fetch_add(1, std::memory_order_acq_rel);
+        futex_wake(&gates[t].go, 1);
+    }
+    for (auto& t : threads)
+        t.join();
+    threads.clear();
+}
@@ -0,0 +1,69 @@
+/**
+ * @file        workpool.hpp
+ * @brief       Persistent pool of pinned worker threads for the thread-sweep benchmarks
+ * @author      rRNA
+ * @version     4.0.0
+ * @date        10-17-2026
+ *
+ * @details
+ * membw, syncbench, vmbench and the spawn storm measure point after point with
+ * one set of threads, so thread creation and first-touch stay out of every
+ * window. Each worker sleeps in FUTEX_WAIT on its own word until release()
+ * hands it a point; workers beyond the point's thread count are never woken,
+ * so a 1-thread point really runs alone on the machine.
+ *
+ *     WorkerPool pool;
+ *     pool.start(cpus, [&](int tid) { ...one point... });
+ *     pool.release(n);    // workers 0..n-1 run the body once
+ *     pool.wait();        // until all n have returned
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+class WorkerPool {
+public:
+    using Body = std::function<void(int tid)>;
+
+    WorkerPool() = default;
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+    ~WorkerPool() { stop(); }
+
+    // One thread per entry of cpus (-1 leaves it unpinned). init runs once in each
+    // thread before it counts as ready, fini once before it exits; start() returns
+    // when every thread is ready.
+    void start(const std::vector<int>& cpus, Body body, Body init = nullptr, Body fini = nullptr);
+
+    // Run body(tid) once in workers 0..active-1; the others stay asleep
+    void release(int active);
+
+    // Block until the workers of the last release() have returned from body()
+    void wait();
+
+    // Wake everyone to run fini and join them
+    void stop();
+
+    int size() const { return static_cast<int>(threads.size()); }
+
+private:
+    struct alignas(64) Gate {
+        std::atomic<uint32_t> go{0};    // futex word, bumped once per release
+    };
+
+    void worker(int tid, int cpu);
+
+    Body body, init, fini;
+    std::unique_ptr<Gate[]> gates;
+    std::vector<std::thread> threads;
+    std::atomic<int> ready{0};
+    std::atomic<uint32_t> done{0};      // futex word, counts returns from body()
+    std::atomic<bool> quit{false};
+    uint32_t active = 0;
+};